@@ -0,0 +1,128 @@
+// CompiledGrammar.cpp:
+// -------------------
+// Objects of class CompiledGrammar are read-only, compact copies of the
+// rules of grammars in a CSR layout, see CompiledGrammar.h.
+//======================================================================
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+#include "SequenceStuff.h"
+#include "Grammar.h"
+#include "CompiledGrammar.h"
+
+
+CompiledGrammar::CompiledGrammar(const Grammar &g) {
+  // 1. dense indices: NTs in topological order, so root has index 0,
+  //   Ts in order of vT
+  Symbol::Id maxId = 0;
+  for (NTSymbol *nt: g.topologicalNts()) {
+    nts.push_back(nt);
+    maxId = max(maxId, nt->id);
+  } // for
+  for (TSymbol *t: g.vT) {
+    ts.push_back(t);
+    maxId = max(maxId, t->id);
+  } // for
+  idxOf.assign(maxId + 1, -1);
+  for (size_t i = 0; i < nts.size(); i++)
+    idxOf[nts[i]->id] = static_cast<int32_t>(i);
+  for (size_t i = 0; i < ts.size(); i++)
+    idxOf[ts[i]->id] = static_cast<int32_t>(i);
+
+  // 2. rows of alternatives and symbols, alternatives in order of rules
+  size_t nrOfAlts = 0, nrOfSyms = 0;
+  for (auto &rule: g.rules) {
+    nrOfAlts += rule.second.size();
+    for (const Sequence *seq: rule.second)
+      nrOfSyms += seq->size();
+  } // for
+  altStart.reserve(nts.size() + 1);
+  lhs.reserve(nrOfAlts);
+  symStart.reserve(nrOfAlts + 1);
+  syms.reserve(nrOfSyms);
+  for (size_t n = 0; n < nts.size(); n++) {
+    altStart.push_back(static_cast<uint32_t>(lhs.size()));
+    for (const Sequence *seq: g.rules[nts[n]]) { // non-inserting for const map
+      lhs.push_back(static_cast<uint32_t>(n));
+      symStart.push_back(static_cast<uint32_t>(syms.size()));
+      for (const Symbol *sy: *seq)
+        syms.push_back((static_cast<Tagged>(idx(sy)) << 1) |
+                       (sy->isNT() ? 1 : 0));
+    } // for
+  } // for
+  altStart.push_back(static_cast<uint32_t>(lhs.size()));
+  symStart.push_back(static_cast<uint32_t>(syms.size()));
+} // CompiledGrammar::CompiledGrammar
+
+
+// same worklist algorithm as in Grammar.cpp, but the occurrences of NTs
+//   are counted directly in the flat rows
+vector<bool> CompiledGrammar::ntsWithCompleteAlternatives(
+                                bool withTerminals) const {
+  const uint32_t n = nrOfNts(), m = nrOfAlternatives();
+  vector<bool> inSet(n, false);
+  vector<uint32_t> worklist;
+  vector<int> count(m, 0);             // per alternative: NTs not in set
+  vector<uint32_t> occStart(n + 1, 0), occs; // per NT: alternatives
+
+  // 1. counters and occurrences of considered alternatives
+  for (uint32_t a = 0; a < m; a++) {
+    bool considered = true;
+    for (const Tagged *sy = begin(a); sy != end(a); sy++)
+      if (isT(*sy)) {
+        considered = withTerminals;
+        if (!considered)
+          break;
+      } else
+        count[a]++;
+    if (!considered)
+      count[a] = -1; // never complete
+    else if (count[a] == 0) {
+      if (!inSet[lhs[a]]) {
+        inSet[lhs[a]] = true;
+        worklist.push_back(lhs[a]);
+      } // if
+    } else
+      for (const Tagged *sy = begin(a); sy != end(a); sy++)
+        if (isNT(*sy))
+          occStart[idxOfTagged(*sy) + 1]++;
+  } // for
+  for (uint32_t nt = 0; nt < n; nt++)
+    occStart[nt + 1] += occStart[nt];
+  occs.resize(occStart.back());
+  vector<uint32_t> occEnd(occStart.begin(), occStart.end() - 1);
+  for (uint32_t a = 0; a < m; a++)
+    if (count[a] > 0)
+      for (const Tagged *sy = begin(a); sy != end(a); sy++)
+        if (isNT(*sy))
+          occs[occEnd[idxOfTagged(*sy)]++] = a;
+
+  // 2. worklist: NTs added to the set decrement the counters
+  while (!worklist.empty()) {
+    uint32_t nt = worklist.back();
+    worklist.pop_back();
+    for (uint32_t o = occStart[nt]; o < occStart[nt + 1]; o++) {
+      uint32_t a = occs[o];
+      if ( (--count[a] == 0) && !inSet[lhs[a]] ) {
+        inSet[lhs[a]] = true;
+        worklist.push_back(lhs[a]);
+      } // if
+    } // for
+  } // while
+  return inSet;
+} // CompiledGrammar::ntsWithCompleteAlternatives
+
+vector<bool> CompiledGrammar::deletableNts() const {
+  return ntsWithCompleteAlternatives(false);
+} // CompiledGrammar::deletableNts
+
+vector<bool> CompiledGrammar::productiveNts() const {
+  return ntsWithCompleteAlternatives(true);
+} // CompiledGrammar::productiveNts
+
+
+// end of CompiledGrammar.cpp
+//======================================================================
@@ -0,0 +1,108 @@
+// CompiledGrammar.h:
+// -----------------
+// Objects of class CompiledGrammar are read-only, compact copies of the
+// rules of grammars for algorithms that traverse all rules many times,
+// e.g., enumeration of languages or parsers. Rules are stored in a
+// compressed sparse row (CSR) layout with dense indices instead of
+// pointers:
+//   NT n has the alternatives altStart[n] .. altStart[n + 1] - 1,
+//   alternative a has the symbols syms[symStart[a] .. symStart[a + 1]),
+// where symbols are tagged indices: (idx << 1) | 1 for the NT with
+// index idx and idx << 1 for the terminal with index idx.
+// Grammar::compiled builds one on demand.
+//======================================================================
+
+#ifndef CompiledGrammar_h
+#define CompiledGrammar_h
+
+#include <cstdint>
+#include <vector>
+
+#include "ObjectCounter.h"
+#include "SymbolStuff.h"
+
+
+class Grammar;
+
+
+// === class CompiledGrammar ===========================================
+
+class CompiledGrammar final // no public base class
+            /*OC+*/ : private ObjectCounter<CompiledGrammar> /*+OC*/ {
+
+  public:
+
+    typedef std::uint32_t Tagged; // tagged index of a T or an NT
+
+  private:
+
+    std::vector<NTSymbol *>     nts;      // by NT index, root has index 0
+    std::vector< TSymbol *>     ts;       // by T index, in order of vT
+    std::vector<std::int32_t>   idxOf;    // by symbol id: index or -1
+    std::vector<std::uint32_t>  altStart; // by NT index, one more entry
+    std::vector<std::uint32_t>  lhs;      // by alternative: its NT index
+    std::vector<std::uint32_t>  symStart; // by alternative, one more entry
+    std::vector<Tagged>         syms;     // symbols of all alternatives
+
+    // NTs having an alternative whose NTs are all in the set, see
+    //   Grammar.cpp; false: deletable NTs, true: productive NTs
+    std::vector<bool> ntsWithCompleteAlternatives(bool withTerminals) const;
+
+  public:
+
+    explicit CompiledGrammar(const Grammar &g); // time linear in size of g
+
+    CompiledGrammar(const CompiledGrammar &cg) = delete;
+    CompiledGrammar &operator=(const CompiledGrammar &cg) = delete;
+
+    ~CompiledGrammar() = default; // non-virtual as class is final
+
+    // tagged indices of symbols
+
+    static bool isNT(Tagged sy) { return (sy & 1) != 0; }
+    static bool isT (Tagged sy) { return (sy & 1) == 0; }
+    static std::uint32_t idxOfTagged(Tagged sy) { return sy >> 1; }
+
+    // mapping between symbols and indices
+
+    std::uint32_t nrOfNts() const { return static_cast<std::uint32_t>(nts.size()); }
+    std::uint32_t nrOfTs()  const { return static_cast<std::uint32_t>(ts.size());  }
+
+    NTSymbol *nt(std::uint32_t idx) const { return nts[idx]; }
+     TSymbol *t (std::uint32_t idx) const { return ts[idx];  }
+    Symbol   *symbolOf(Tagged sy) const {
+      return isNT(sy) ? static_cast<Symbol *>(nts[sy >> 1]) : ts[sy >> 1];
+    } // symbolOf
+
+    int idx(const Symbol *sy) const { // index of sy or -1 if not in grammar
+      return (sy->id < idxOf.size()) ? idxOf[sy->id] : -1;
+    } // idx
+
+    // rules: alternatives of NT n are firstAlt(n) .. endAlt(n) - 1
+
+    std::uint32_t nrOfAlternatives() const {
+      return static_cast<std::uint32_t>(lhs.size());
+    } // nrOfAlternatives
+
+    std::uint32_t firstAlt(std::uint32_t n) const { return altStart[n];     }
+    std::uint32_t endAlt  (std::uint32_t n) const { return altStart[n + 1]; }
+    std::uint32_t lhsOf   (std::uint32_t a) const { return lhs[a];          }
+
+    const Tagged *begin(std::uint32_t a) const { return syms.data() + symStart[a];     }
+    const Tagged *end  (std::uint32_t a) const { return syms.data() + symStart[a + 1]; }
+    int length(std::uint32_t a) const {
+      return static_cast<int>(symStart[a + 1] - symStart[a]);
+    } // length
+
+    // analyses on the compact rules, by NT index, in linear time
+
+    std::vector<bool> deletableNts()  const; // NT =>* eps
+    std::vector<bool> productiveNts() const; // NT =>* terminal sequence
+
+}; // CompiledGrammar
+
+
+#endif
+
+// end of CompiledGrammar.h
+//======================================================================
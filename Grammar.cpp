@@ -10,9 +10,12 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <stdexcept>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -20,141 +23,573 @@ using namespace std;
 #include "GrammarBasics.h"
 #include "GrammarBuilder.h"
 #include "Grammar.h"
+#include "CompiledGrammar.h"
 
 
 // macro used in operator<<:
 #define LIST_RULES_IN_TOPOLOGIC_ORDER    // #undef for lexicographic order
 
 
-// === implementation of class Grammar =================================
-
-Grammar::Grammar(NTSymbol *const root, const RulesMap &rules,
-                 const VNt &vNt, const VT &vT, const V &v)
-: root(root), rules(rules), vNt(vNt), vT(vT), v(v) {
-  // nothing left to do
-} // Grammar::Grammar
-
-
-VNt Grammar::deletableNTs() const {
-  VNt vNtDel;
-
-  // 1. look for NTs with an empty sequence
+// === analyses of grammars ============================================
+//
+// Functions computing the analyses from rules, the results are cached
+// in Grammar::Analyses.
+
+// least set of NTs having an alternative whose NTs are all in the set,
+//   computed with a worklist in time linear in the size of the grammar:
+//   every alternative counts its NT occurrences that are not known to be
+//   in the set yet; when an NT is added, the counters of all its
+//   occurrences are decremented and an alternative reaching 0 adds its
+//   left-hand side; alternatives with terminals are only considered if
+//   withTerminals, so the result are the deletable NTs without and the
+//   productive NTs with them
+static VNt ntsWithCompleteAlternatives(const RulesMap &rules,
+                                       bool withTerminals) {
+
+  auto considered = [withTerminals](const Sequence *seq) {
+    return withTerminals || (seq->terminalLength() == 0);
+  };
+
+  // 1. dense indices of the NTs, in the (sorted) order of rules, and
+  //   NTs with an alternative without NTs, without them the set is empty
+  vector<NTSymbol *> nts;
+  vector<bool> inSet;
+  vector<int> worklist; // NTs in set, not processed yet
+  nts.reserve(rules.size());
+  inSet.reserve(rules.size());
+  Symbol::Id maxId = 0;
   for (auto &rule: rules) {
-    for (Sequence *seq: rule.second) {
-      if (seq->isEpsilon()) {
-        vNtDel.insert(const_cast<NTSymbol *>(rule.first));
+    nts.push_back(rule.first);
+    maxId = max(maxId, rule.first->id);
+    inSet.push_back(false);
+    for (const Sequence *seq: rule.second)
+      if ( considered(seq) && (seq->length() == seq->terminalLength()) ) {
+        inSet.back() = true;
+        worklist.push_back(static_cast<int>(nts.size() - 1));
         break;
       } // if
-    } // for
   } // for
+  if (worklist.empty())
+    return VNt();
+  vector<int> ntIdxOf(maxId + 1, -1); // by symbol id
+  for (size_t nt = 0; nt < nts.size(); nt++)
+    ntIdxOf[nts[nt]->id] = static_cast<int>(nt);
+  auto ntIdx = [&ntIdxOf](const Symbol *sy) {
+    if (sy->isT() || (sy->id >= ntIdxOf.size()))
+      return -1;
+    return ntIdxOf[sy->id]; // -1: NT without rule, never in set
+  };
+
+  // 2. counters of the other alternatives and, per NT,
+  //   the alternatives it occurs in (as compressed rows)
+  vector<int> lhsOf, count; // per alternative
+  vector<int> occStart(nts.size() + 1, 0), occs;
+  int i = 0;
+  for (auto &rule: rules) {
+    for (const Sequence *seq: rule.second)
+      if ( considered(seq) && (seq->length() > seq->terminalLength()) ) {
+        for (const Symbol *sy: *seq)
+          if (ntIdx(sy) >= 0)
+            occStart[ntIdx(sy) + 1]++;
+        lhsOf.push_back(i);
+        count.push_back(seq->length() - seq->terminalLength());
+      } // if
+    i++;
+  } // for
+  for (size_t nt = 0; nt < nts.size(); nt++)
+    occStart[nt + 1] += occStart[nt];
+  occs.resize(occStart.back());
+  vector<int> occEnd(occStart.begin(), occStart.end() - 1);
+  int alt = 0;
+  for (auto &rule: rules)
+    for (const Sequence *seq: rule.second)
+      if ( considered(seq) && (seq->length() > seq->terminalLength()) ) {
+        for (const Symbol *sy: *seq)
+          if (ntIdx(sy) >= 0)
+            occs[occEnd[ntIdx(sy)]++] = alt;
+        alt++;
+      } // if
 
-  // 2. look for NTs having at least one deletable sequence
-  size_t oldSize;
-  do {
-    oldSize = vNtDel.size();
-    for (auto &rule: rules) {
-      if (!vNtDel.contains(const_cast<NTSymbol *>(rule.first))) {
-        for (Sequence *seq: rule.second) {
-          bool seqIsDeletable = true;
-          for (const Symbol *sy: *seq) {
-            if (   sy->isT () ||
-                 ( sy->isNT() &&
-                  !vNtDel.contains(dynamic_cast<NTSymbol *>(
-                                     const_cast<Symbol   *>(sy))) ) ) {
-              seqIsDeletable = false;
-              break;
-            } // if
-          } // for
-          if (seqIsDeletable) {
-            vNtDel.insert(const_cast<NTSymbol *>(rule.first));
-            break;
-          } // if
-        } // for
+  // 3. propagate along the occurrences
+  while (!worklist.empty()) {
+    int nt = worklist.back();
+    worklist.pop_back();
+    for (int o = occStart[nt]; o < occStart[nt + 1]; o++) {
+      int a = occs[o];
+      if ( (--count[a] == 0) && !inSet[lhsOf[a]] ) {
+        inSet[lhsOf[a]] = true;
+        worklist.push_back(lhsOf[a]);
       } // if
     } // for
-  } while (vNtDel.size() > oldSize);
-
-  return vNtDel;
-} // Grammar::deletableNTs
-
-
-bool Grammar::isEpsilonFree() const {
-  for (auto &rule: rules) {
-    if (rule.first != root)  // empty seq. allowed for root only
-      for (Sequence *seq: rule.second) {
-        if (seq->isEpsilon())
-          return false;
+  } // while
+
+  VNt result;
+  for (size_t nt = 0; nt < nts.size(); nt++)
+    if (inSet[nt])
+      result.insert(nts[nt]); // in order, so appended
+  return result;
+} // ntsWithCompleteAlternatives
+
+// NTs reachable from root, with a worklist in linear time
+static VNt reachableNTsOf(const RulesMap &rules, NTSymbol *root) {
+  vector<bool> reached; // by symbol id
+  auto reach = [&reached](NTSymbol *nt) { // true if nt is new
+    if (nt->id >= reached.size())
+      reached.resize(nt->id + 1, false);
+    if (reached[nt->id])
+      return false;
+    reached[nt->id] = true;
+    return true;
+  };
+  vector<NTSymbol *> worklist;
+  reach(root);
+  worklist.push_back(root);
+  while (!worklist.empty()) {
+    NTSymbol *nt = worklist.back();
+    worklist.pop_back();
+    for (const Sequence *seq: rules[nt]) // non-inserting for const map
+      for (Symbol *sy: *seq)
+        if (sy->isNT() && reach(asNT(sy)))
+          worklist.push_back(asNT(sy));
+  } // while
+  VNt result;
+  for (auto &rule: rules) // insertions in order
+    if ( (rule.first->id < reached.size()) && reached[rule.first->id] )
+      result.insert(rule.first);
+  return result;
+} // reachableNTsOf
+
+// strongly connected components of a directed graph with nodes
+//   0 .. n - 1 and the successors of node v in adj[adjStart[v] ..
+//   adjStart[v + 1]), with an iterative version of Tarjan's algorithm;
+//   component c has the nodes members[sccStart[c] .. sccStart[c + 1]),
+//   components are numbered such that successors come first
+static void sccsOf(int n, const vector<int> &adjStart, const vector<int> &adj,
+                   vector<int> &sccOf, vector<int> &members,
+                   vector<int> &sccStart) {
+  vector<int> index(n, -1), low(n, 0);
+  vector<int> stack;                // nodes of unfinished components
+  vector<pair<int, int> > calls;    // nodes and their next successors
+  int nrOfVisited = 0;
+  sccOf.assign(n, -1);
+  members.clear();
+  members.reserve(n);
+  sccStart.assign(1, 0);
+  auto visit = [&](int v) {
+    index[v] = low[v] = nrOfVisited++;
+    stack.push_back(v);
+    calls.push_back(make_pair(v, adjStart[v]));
+  };
+  for (int start = 0; start < n; start++) {
+    if (index[start] >= 0)
+      continue;
+    visit(start);
+    while (!calls.empty()) {
+      int v = calls.back().first;
+      if (calls.back().second < adjStart[v + 1]) {
+        int w = adj[calls.back().second++];
+        if (index[w] < 0)
+          visit(w);
+        else if (sccOf[w] < 0) // w is on stack
+          low[v] = min(low[v], index[w]);
+        continue;
+      } // if
+      calls.pop_back();
+      if (!calls.empty())
+        low[calls.back().first] = min(low[calls.back().first], low[v]);
+      if (low[v] == index[v]) { // v is the root of a component
+        int scc = static_cast<int>(sccStart.size()) - 1, w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          sccOf[w] = scc;
+          members.push_back(w);
+        } while (w != v);
+        sccStart.push_back(static_cast<int>(members.size()));
+      } // if
+    } // while
+  } // for
+} // sccsOf
+
+// solves set constraints set[v] >= set[w] for all edges v -> w where
+//   the sets are rows of bitsets initialized with the constant parts:
+//   component by component, successors first, all nodes of a component
+//   get the same set
+static void propagateAlongSccs(int n, const vector<int> &adjStart,
+                               const vector<int> &adj,
+                               size_t nrOfWords, vector<uint64_t> &sets) {
+  vector<int> sccOf, members, sccStart;
+  sccsOf(n, adjStart, adj, sccOf, members, sccStart);
+  vector<uint64_t> acc(nrOfWords);
+  for (size_t scc = 0; scc + 1 < sccStart.size(); scc++) {
+    fill(acc.begin(), acc.end(), 0);
+    for (int m = sccStart[scc]; m < sccStart[scc + 1]; m++) {
+      int v = members[m];
+      for (size_t i = 0; i < nrOfWords; i++)
+        acc[i] |= sets[v * nrOfWords + i];
+      for (int e = adjStart[v]; e < adjStart[v + 1]; e++)
+        if (sccOf[adj[e]] != static_cast<int>(scc)) // finished before
+          for (size_t i = 0; i < nrOfWords; i++)
+            acc[i] |= sets[adj[e] * nrOfWords + i];
+    } // for
+    for (int m = sccStart[scc]; m < sccStart[scc + 1]; m++)
+      copy(acc.begin(), acc.end(), sets.begin() + members[m] * nrOfWords);
+  } // for
+} // propagateAlongSccs
+
+// adjacency lists in compressed rows from a list of edges
+static void compressEdges(int n, const vector<pair<int, int> > &edges,
+                          vector<int> &adjStart, vector<int> &adj) {
+  adjStart.assign(n + 1, 0);
+  for (auto &e: edges)
+    adjStart[e.first + 1]++;
+  for (int v = 0; v < n; v++)
+    adjStart[v + 1] += adjStart[v];
+  adj.resize(edges.size());
+  vector<int> pos(adjStart.begin(), adjStart.end() - 1);
+  for (auto &e: edges)
+    adj[pos[e.first]++] = e.second;
+} // compressEdges
+
+
+// FIRST and FOLLOW sets as rows of bitsets over dense indices of
+//   the terminals, one row per NT, both computed in time linear in the
+//   size of the grammar (times the nr. of words per row): the set
+//   constraints between NTs form a graph whose strongly connected
+//   components are solved one after the other, see propagateAlongSccs
+struct Grammar::TSets {
+
+  vector<NTSymbol *> nts;   // in order of rules
+  vector< TSymbol *> ts;    // in order of vT
+  vector<int>        idxOf; // by symbol id: index in nts or ts, else -1
+  vector<bool>       deletable; // per NT
+  size_t             nrOfWords; // per row
+  vector<uint64_t>   first, follow;
+
+  TSets(const Grammar &g);
+
+  int idx(const Symbol *sy) const {
+    return (sy->id < idxOf.size()) ? idxOf[sy->id] : -1;
+  } // idx
+
+  // row |= FIRST(symbols [begin, end)), returns true if deletable
+  bool addFirst(Sequence::const_iterator begin, Sequence::const_iterator end,
+                uint64_t *row) const;
+
+  TSetsMap tSetsMapOf(const vector<uint64_t> &sets) const;
+
+}; // Grammar::TSets
+
+Grammar::TSets::TSets(const Grammar &g) {
+  const VNt &vNtDel = g.deletableNTs();
+  vector<const SequenceSet *> altsOf; // per NT
+  Symbol::Id maxId = 0;
+  for (auto &rule: g.rules) {
+    nts.push_back(rule.first);
+    altsOf.push_back(&rule.second);
+    deletable.push_back(vNtDel.contains(rule.first));
+    maxId = max(maxId, rule.first->id);
+  } // for
+  for (TSymbol *t: g.vT) {
+    ts.push_back(t);
+    maxId = max(maxId, t->id);
+  } // for
+  idxOf.assign(maxId + 1, -1);
+  for (size_t i = 0; i < nts.size(); i++)
+    idxOf[nts[i]->id] = static_cast<int>(i);
+  for (size_t i = 0; i < ts.size(); i++)
+    idxOf[ts[i]->id] = static_cast<int>(i);
+  nrOfWords = (ts.size() + 63) / 64;
+  const int n = static_cast<int>(nts.size());
+  vector<pair<int, int> > edges;
+  vector<int> adjStart, adj;
+
+  // 1. FIRST: terminals at the start and edges A -> B for the NTs B
+  //   at the start of alternatives of A, i.e., after deletable NTs only
+  first.assign(n * nrOfWords, 0);
+  for (int a = 0; a < n; a++)
+    for (const Sequence *seq: *altsOf[a])
+      for (const Symbol *sy: *seq) {
+        int i = idx(sy);
+        if (sy->isT()) {
+          first[a * nrOfWords + i / 64] |= uint64_t(1) << (i % 64);
+          break;
+        } // if
+        if (i < 0) // NT without rule
+          break;
+        edges.push_back(make_pair(a, i));
+        if (!deletable[i])
+          break;
       } // for
+  compressEdges(n, edges, adjStart, adj);
+  propagateAlongSccs(n, adjStart, adj, nrOfWords, first);
+
+  // 2. FOLLOW: FIRST of the rest of alternatives for the NTs in them,
+  //   with alternatives scanned backwards, and edges B -> A for NTs B
+  //   in alternatives of A followed by deletable rests only
+  follow.assign(n * nrOfWords, 0);
+  edges.clear();
+  vector<uint64_t> trailer(nrOfWords);
+  for (int a = 0; a < n; a++)
+    for (const Sequence *seq: *altsOf[a]) {
+      fill(trailer.begin(), trailer.end(), 0);
+      bool restIsDeletable = true;
+      for (auto it = seq->end(); it != seq->begin(); ) {
+        const Symbol *sy = *--it;
+        int i = idx(sy);
+        if (sy->isT()) {
+          fill(trailer.begin(), trailer.end(), 0);
+          trailer[i / 64] = uint64_t(1) << (i % 64);
+          restIsDeletable = false;
+          continue;
+        } // if
+        if (i < 0) { // NT without rule, derives nothing
+          fill(trailer.begin(), trailer.end(), 0);
+          restIsDeletable = false;
+          continue;
+        } // if
+        for (size_t w = 0; w < nrOfWords; w++)
+          follow[i * nrOfWords + w] |= trailer[w];
+        if (restIsDeletable)
+          edges.push_back(make_pair(i, a));
+        if (!deletable[i]) {
+          fill(trailer.begin(), trailer.end(), 0);
+          restIsDeletable = false;
+        } // if
+        for (size_t w = 0; w < nrOfWords; w++)
+          trailer[w] |= first[i * nrOfWords + w];
+      } // for
+    } // for
+  compressEdges(n, edges, adjStart, adj);
+  propagateAlongSccs(n, adjStart, adj, nrOfWords, follow);
+} // Grammar::TSets::TSets
+
+bool Grammar::TSets::addFirst(Sequence::const_iterator begin,
+                              Sequence::const_iterator end,
+                              uint64_t *row) const {
+  for (auto it = begin; it != end; it++) {
+    int i = idx(*it);
+    if ((*it)->isT()) {
+      if (i >= 0) // a terminal of the grammar
+        row[i / 64] |= uint64_t(1) << (i % 64);
+      return false;
+    } // if
+    if (i < 0) // NT without rule
+      return false;
+    for (size_t w = 0; w < nrOfWords; w++)
+      row[w] |= first[i * nrOfWords + w];
+    if (!deletable[i])
+      return false;
   } // for
   return true;
-} //  Grammar::isEpsilonFree
-
-
-bool Grammar::rootHasEpsilonAlternative() const {
-  for (Sequence *seq: rules.find(root)->second) {
-    if (seq->isEpsilon()) // root -> ... | EPS | ...
-     return true;
+} // Grammar::TSets::addFirst
+
+TSetsMap Grammar::TSets::tSetsMapOf(const vector<uint64_t> &sets) const {
+  TSetsMap tSetsMap;
+  for (size_t a = 0; a < nts.size(); a++) {
+    VT &vt = tSetsMap[nts[a]];
+    for (size_t w = 0; w < nrOfWords; w++)
+      for (uint64_t bits = sets[a * nrOfWords + w]; bits != 0;
+                    bits &= bits - 1) // in order of ts, so appended
+        vt.insert(ts[w * 64 + __builtin_ctzll(bits)]);
   } // for
-  return false;
-} // Grammar::rootHasEpsilonAlternative
+  return tSetsMap;
+} // Grammar::TSets::tSetsMapOf
 
 
-#ifdef LIST_RULES_IN_TOPOLOGIC_ORDER
-static vector<NTSymbol *> topSortedNts(const Grammar &g) {
+// NTs in breadth-first order from root, followed by the unreachable ones
+//   in the order of rules; the vector itself is the queue and a bitset
+//   by symbol id marks the NTs in it, so time is linear in the size of g
+static vector<NTSymbol *> topologicalNtsOf(const RulesMap &rules,
+                                           NTSymbol *root) {
   vector<NTSymbol *> ntv;       // topologically sorted nonterminals
-  ntv.push_back(g.root);        // start with root nonterminal
-
-  // 1. insert reachable nonterminals
+  vector<bool> inNtv;           // by symbol id
+  auto append = [&ntv, &inNtv](NTSymbol *nt) {
+    if (nt->id >= inNtv.size())
+      inNtv.resize(nt->id + 1, false);
+    if (!inNtv[nt->id]) {
+      inNtv[nt->id] = true;
+      ntv.push_back(nt);
+    } // if
+  };
+  ntv.reserve(rules.size());
+  append(root);                 // start with root nonterminal
+
+  // 1. append reachable nonterminals
   for (size_t i = 0; i < ntv.size(); i++)
-    for (const Sequence *seq: const_cast<Grammar &>(g).rules[ntv[i]])
-      for (const Symbol *sy: *seq)
-        if (sy->isNT()) {
-          NTSymbol *ntSy = (NTSymbol *)sy;
-          if (find(ntv.begin(), ntv.end(), ntSy) ==
-              ntv.end())        // sy is not in ntvs yet
-            ntv.push_back(ntSy);
-        } // if
+    for (const Sequence *seq: rules[ntv[i]]) // non-inserting for const map
+      for (Symbol *sy: *seq)
+        if (sy->isNT())
+          append(asNT(sy));
 
-  //2. insert unreachable nonterminals, too
-  for (auto &rule: g.rules)
-    if (find(ntv.begin(), ntv.end(), rule.first) ==
-      ntv.end())                // nonterminal is not in ntv yet
-      ntv.push_back(rule.first);
+  // 2. append unreachable nonterminals, too
+  for (auto &rule: rules)
+    append(rule.first);
 
   return ntv;
-} // topSortedNts
-#endif
+} // topologicalNtsOf
+
+
+// === implementation of class Grammar =================================
+
+struct Grammar::Analyses {
+
+  once_flag deletableFlag, reachableFlag, productiveFlag,
+            tSetsFlag, firstFlag, followFlag, epsilonFlag, topologicalFlag,
+            compiledFlag;
+
+  unique_ptr<TSets> tSets;
+  unique_ptr<CompiledGrammar> compiled;
+
+  VNt deletable, reachable, productive;
+  TSetsMap first, follow;
+  bool epsilonFree = false, rootHasEpsilonAlternative = false;
+  vector<NTSymbol *> topological;
+
+}; // Grammar::Analyses
+
+
+Grammar::Grammar(NTSymbol *const root, RulesMap &&rules,
+                 VNt &&vNt, VT &&vT, V &&v)
+: data(make_shared<const Data>(Data{std::move(rules), std::move(vNt),
+                                     std::move(vT), std::move(v)})),
+  analyses(make_shared<Analyses>()),
+  root(root), rules(data->rules),
+  vNt(data->vNt), vT(data->vT), v(data->v) {
+  vNt.sort(); // once, before copies of this grammar are used by threads
+  vT.sort();
+  v.sort();
+} // Grammar::Grammar
+
 
+const VNt &Grammar::deletableNTs() const {
+  call_once(analyses->deletableFlag, [this]() {
+    analyses->deletable = ntsWithCompleteAlternatives(rules, false);
+  });
+  return analyses->deletable;
+} // Grammar::deletableNTs
+
+const VNt &Grammar::reachableNTs() const {
+  call_once(analyses->reachableFlag, [this]() {
+    analyses->reachable = reachableNTsOf(rules, root);
+  });
+  return analyses->reachable;
+} // Grammar::reachableNTs
+
+const VNt &Grammar::productiveNTs() const {
+  call_once(analyses->productiveFlag, [this]() {
+    analyses->productive = ntsWithCompleteAlternatives(rules, true);
+  });
+  return analyses->productive;
+} // Grammar::productiveNTs
+
+const Grammar::TSets &Grammar::tSets() const {
+  call_once(analyses->tSetsFlag, [this]() {
+    analyses->tSets = make_unique<TSets>(*this);
+  });
+  return *analyses->tSets;
+} // Grammar::tSets
+
+const TSetsMap &Grammar::firstSets() const {
+  call_once(analyses->firstFlag, [this]() {
+    analyses->first = tSets().tSetsMapOf(tSets().first);
+  });
+  return analyses->first;
+} // Grammar::firstSets
+
+const TSetsMap &Grammar::followSets() const {
+  call_once(analyses->followFlag, [this]() {
+    analyses->follow = tSets().tSetsMapOf(tSets().follow);
+  });
+  return analyses->follow;
+} // Grammar::followSets
+
+VT Grammar::first(const Sequence &seq) const {
+  const TSets &ts = tSets();
+  vector<uint64_t> row(ts.nrOfWords, 0);
+  ts.addFirst(seq.begin(), seq.end(), row.data());
+  VT vt;
+  for (size_t w = 0; w < row.size(); w++)
+    for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1)
+      vt.insert(ts.ts[w * 64 + __builtin_ctzll(bits)]);
+  return vt;
+} // Grammar::first
+
+const CompiledGrammar &Grammar::compiled() const {
+  call_once(analyses->compiledFlag, [this]() {
+    analyses->compiled = make_unique<CompiledGrammar>(*this);
+  });
+  return *analyses->compiled;
+} // Grammar::compiled
+
+const vector<NTSymbol *> &Grammar::topologicalNts() const {
+  call_once(analyses->topologicalFlag, [this]() {
+    analyses->topological = topologicalNtsOf(rules, root);
+  });
+  return analyses->topological;
+} // Grammar::topologicalNts
+
+
+// both properties in one scan over the rules
+static void scanForEpsilonAlternatives(const Grammar &g, bool &epsilonFree,
+                                       bool &rootHasEpsilonAlternative) {
+  epsilonFree = true;
+  rootHasEpsilonAlternative = false;
+  for (auto &rule: g.rules)
+    for (Sequence *seq: rule.second)
+      if (seq->isEpsilon()) {
+        if (rule.first == g.root) // root -> ... | EPS | ...
+          rootHasEpsilonAlternative = true;
+        else                      // empty seq. allowed for root only
+          epsilonFree = false;
+      } // if
+} // scanForEpsilonAlternatives
+
+bool Grammar::isEpsilonFree() const {
+  call_once(analyses->epsilonFlag, [this]() {
+    scanForEpsilonAlternatives(*this, analyses->epsilonFree,
+                               analyses->rootHasEpsilonAlternative);
+  });
+  return analyses->epsilonFree;
+} //  Grammar::isEpsilonFree
+
+bool Grammar::rootHasEpsilonAlternative() const {
+  call_once(analyses->epsilonFlag, [this]() {
+    scanForEpsilonAlternatives(*this, analyses->epsilonFree,
+                               analyses->rootHasEpsilonAlternative);
+  });
+  return analyses->rootHasEpsilonAlternative;
+} // Grammar::rootHasEpsilonAlternative
+
+
+// rules are formatted into a buffer, which is written at once without
+//   any flush, instead of writing and flushing line by line
 ostream& operator<<(ostream &os, const Grammar &g) {
-  vector<NTSymbol *> ntv;  // vector of nonterminals
 #ifdef LIST_RULES_IN_TOPOLOGIC_ORDER
-  ntv = topSortedNts(g);
+  const vector<NTSymbol *> &ntv = g.topologicalNts(); // cached
 #else // list rules in lexicographic order
+  vector<NTSymbol *> ntv;  // vector of nonterminals
   for (auto &rule: g.rules)
     ntv.push_back(rule.first);
 #endif
-  os << endl;
-  os << "G(" << *g.root << "):" << endl;
+  ostringstream buf;
+  buf << "\nG(" << *g.root << "):\n";
   for (NTSymbol *ntSy: ntv) {
-    os << *ntSy << " -> ";
+    buf << *ntSy << " -> ";
     bool first = true;
-    for (const Sequence *seq: const_cast<Grammar &>(g).rules[ntSy]) {
+    for (const Sequence *seq: g.rules[ntSy]) { // non-inserting for const map
       if (!first)
-        os << " | ";
-      os << *seq;
+        buf << " | ";
+      buf << *seq;
       first = false;
     } // for
-    os << endl;
+    buf << '\n';
   } // for
-  os << "---" << endl;
-  os << "VNt = " << g.vNt;
-
-  VNt vNtDel = g.deletableNTs();
-  os << ", deletable: " << vNtDel;
-
-  os << endl;
-  os << "VT  = " << g.vT << endl;
-  os << endl;
+  buf << "---\n";
+  buf << "VNt = " << g.vNt;
+  buf << ", deletable: " << g.deletableNTs() << '\n';
+  buf << "VT  = " << g.vT << "\n\n";
+  os << buf.str();
   return os;
 } // operator<<
 
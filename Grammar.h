@@ -10,6 +10,7 @@
 #include <initializer_list>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,6 +21,9 @@
 #include "GrammarBasics.h"
 
 
+class CompiledGrammar;
+
+
 // === class Grammar ===================================================
 
 class Grammar // no public base class
@@ -33,26 +37,64 @@ class Grammar // no public base class
 
     mutable SymbolPool sp;
 
-    // constructor called by GrammarBuilder::buildGrammar only
-    Grammar(NTSymbol *const root, const RulesMap &rules,
-            const VNt &vnt, const VT &vT, const V &v);
+    // immutable data components, held in a reference-counted block, so
+    //   copies of a grammar are O(1) and share it; the last copy destroyed
+    //   (on whatever thread) destroys the block
+    struct Data {
+      RulesMap rules;
+      VNt      vNt;
+      VT       vT;
+      V        v;
+    }; // Data
+    std::shared_ptr<const Data> data;
+
+    // results of analyses, each computed once on first use (thread safe),
+    //   copies of a grammar share them as grammars don't change
+    struct Analyses;
+    std::shared_ptr<Analyses> analyses;
+
+    struct TSets; // FIRST and FOLLOW sets as bitsets
+    const TSets &tSets() const;
+
+    // constructor called by GrammarBuilder::buildGrammar only,
+    //   takes over the data components
+    Grammar(NTSymbol *const root, RulesMap &&rules,
+            VNt &&vnt, VT &&vT, V &&v);
 
   public:
 
-    // data components: same as in class GrammarBuilder but all const
+    // data components: same as in class GrammarBuilder but all const,
+    //   the references refer to the shared block data
 
           NTSymbol *const root;  // no ownership: SymbolPool is the owner of all symbols
-    const RulesMap        rules; // has at least an empty rule for root
-    const VNt             vNt;   // all nonterminals for rules, including root
-    const VT              vT;    // all terminals occuring in rules
-    const V               v;     // all symbols, union of vNt and vT
+    const RulesMap       &rules; // has at least an empty rule for root
+    const VNt            &vNt;   // all nonterminals for rules, including root
+    const VT             &vT;    // all terminals occuring in rules
+    const V              &v;     // all symbols, union of vNt and vT
 
-    Grammar(const Grammar &g) = default; // useless as grammars don't change
+    Grammar(const Grammar &g) = default; // O(1): shares data and analyses
     Grammar &operator=(const Grammar &g) = delete; // impossible because of const data
 
     virtual ~Grammar() = default;
 
-    VNt deletableNTs() const;    // returns a subset of vNt
+    // analyses, computed once and cached, so repeated calls cost nothing
+
+    const VNt &deletableNTs() const;  // NT =>* eps, a subset of vNt
+    const VNt &reachableNTs() const;  // root =>* ... NT ...
+    const VNt &productiveNTs() const; // NT =>* terminal sequence
+
+    const TSetsMap &firstSets() const;  // FIRST(NT) for all NTs in vNt
+    const TSetsMap &followSets() const; // FOLLOW(NT) for all NTs in vNt,
+                                        //   end of input not represented
+
+    VT first(const Sequence &seq) const; // FIRST(seq), e.g. of an alternative
+
+    // NTs in breadth-first order of reachability from root, followed by
+    //   the unreachable ones, e.g., for operator<<
+    const std::vector<NTSymbol *> &topologicalNts() const;
+
+    // rules in a compact CSR layout for hot algorithms, see CompiledGrammar.h
+    const CompiledGrammar &compiled() const;
 
     bool isEpsilonFree() const;  // only root may have an epsilon alternative
     bool rootHasEpsilonAlternative() const; // S -> ... | EPS | ...
@@ -22,6 +22,15 @@ const SequenceSet &RulesMap::operator[](NTSymbol *ntSy) const {
     return constEmptyElement;
 } // RulesMap::operator[]
 
+// non-inserting lookup by name, LessForSymbolPtrs compares with names
+const SequenceSet &RulesMap::operator[](string_view ntName) const {
+  auto it = Base::find(ntName);
+  if (it != Base::end()) // an element (rule) exists
+    return it->second;
+  else
+    return constEmptyElement;
+} // RulesMap::operator[]
+
 
 // === test ============================================================
 
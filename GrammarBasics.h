@@ -8,6 +8,7 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 
 #include "ObjectCounter.h"
 #include "Vocabulary.h"
@@ -19,9 +20,17 @@ typedef Vocabulary<NTSymbol> VNt;
 typedef Vocabulary< TSymbol> VT;
 typedef Vocabulary<  Symbol> V; // for union of VNt and VT
 
+// sets of terminals per nonterminal, e.g. FIRST and FOLLOW sets
+typedef std::map<NTSymbol *, VT, LessForSymbolPtrs> TSetsMap;
+
 // Rule takes ownership of its SequenceSet (= alternatives)
 typedef std::pair<const NTSymbol *, SequenceSet> Rule;
 
+// RulesMap variant for GrammarBuilder: the alternatives of rules are
+//   deduplicated by hashing and sorted only once when a Grammar is built
+typedef std::map<NTSymbol *, UnorderedSequenceSet, LessForSymbolPtrs>
+        UnorderedRulesMap;
+
 // === class RulesMap ==================================================
 
 class RulesMap: public std::map<NTSymbol *, SequenceSet, LessForSymbolPtrs>
@@ -39,6 +48,10 @@ public:
   const SequenceSet &operator[](NTSymbol *ntSy) const;
     // returns constEmptyElement when ntSy is not in map
 
+  // non-inserting lookup by name of nonterminal, does not allocate
+  const SequenceSet &operator[](std::string_view ntName) const;
+    // returns constEmptyElement when there is no rule for ntName
+
 }; // RulesMap
 
 
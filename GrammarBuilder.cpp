@@ -5,12 +5,28 @@
 //======================================================================
 
 
+#include <cstdint>
 #include <cstring>
+
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAP_FILES
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -29,114 +45,372 @@ void GrammarBuilder::initialize(NTSymbol *root) {
 } // GrammarBuilder::initialize
 
 
-void GrammarBuilder::readGrammar(istream &is) {
-  string line, sy, rootNt, nt, ntSy, arrowSy;
-  bool firstNonEmptyLine;
-  unordered_map<string, NTSymbol *> ntMap;
-  unordered_map<string, TSymbol  *>  tMap;
+// === contents of files ===============================================
+//
+// Read-only view of the whole contents of a file: on POSIX systems a
+// regular file is mapped into memory, so its pages are only read on
+// demand by the scanner and never copied, else it is read into a string.
 
-  SymbolPool sp;
+class FileText final {
 
-  // 1. read file and map nonterminals
-  firstNonEmptyLine = true;
-  while (!is.eof()) {
-    line = "";
-    getline(is, line);
-    if (is.fail())
-      break;
-    sy = "";
-    istringstream(line) >> sy;
-    if (sy == "" || sy.substr(0, 2) == "//") // skip empty or comment line
+  private:
+
+    string_view contents;
+    void       *mapped = nullptr; // start of mapping or nullptr
+    string      buffer;           // contents if not mapped
+
+  public:
+
+    explicit FileText(const string &fileName);
+
+    FileText(const FileText &ft) = delete;
+    FileText &operator=(const FileText &ft) = delete;
+
+    ~FileText();
+
+    string_view text() const {
+      return contents;
+    } // text
+
+}; // FileText
+
+#ifdef MAP_FILES
+
+FileText::FileText(const string &fileName) {
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw invalid_argument("file \"" + fileName + "\" not found");
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw runtime_error("file \"" + fileName + "\" not readable");
+  } // if
+  const size_t size = static_cast<size_t>(st.st_size);
+  if (S_ISREG(st.st_mode) && (size > 0)) { // mapping of empty files is not possible
+    mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      throw runtime_error("file \"" + fileName + "\" cannot be mapped");
+    } // if
+    madvise(mapped, size, MADV_SEQUENTIAL); // a hint only, so no check
+    contents = string_view(static_cast<const char *>(mapped), size);
+  } else { // FIFO, e.g., /dev/stdin or /dev/fd/63 from <(...), device or
+           //   a file with size 0 in st, e.g., in /proc: read until EOF
+    char chunk[1 << 16];
+    ssize_t n;
+    while ( (n = read(fd, chunk, sizeof(chunk))) != 0 ) {
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        close(fd);
+        throw runtime_error("file \"" + fileName + "\" not readable");
+      } // if
+      buffer.append(chunk, static_cast<size_t>(n));
+    } // while
+    contents = buffer;
+  } // else
+  close(fd); // mapping stays valid
+} // FileText::FileText
+
+FileText::~FileText() {
+  if (mapped != nullptr)
+    munmap(mapped, contents.size());
+} // FileText::~FileText
+
+#else // no memory mapped files
+
+FileText::FileText(const string &fileName) {
+  ifstream ifs(fileName, ios::binary);
+  if (!ifs.good())
+    throw invalid_argument("file \"" + fileName + "\" not found");
+  buffer.assign(istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+  contents = buffer;
+} // FileText::FileText
+
+FileText::~FileText() {
+  // nothing to do
+} // FileText::~FileText
+
+#endif
+
+
+// === scanner for grammar texts =======================================
+//
+// Hand-written scanner over the bytes of a whole grammar text, e.g., of
+// a memory-mapped file, or of complete lines of a chunk of a stream:
+// tokens are string_views into the text, so scanning neither copies nor
+// allocates, and the line and column of each token are known for error
+// messages.
+
+class GrammarScanner final {
+
+  private:
+
+    string_view text;
+    size_t pos       = 0; // next byte to scan
+    size_t lineStart = 0; // first byte of current line
+    int    lnr       = 1; // current line
+
+    static bool isBlank(char c) { // white space within a line
+      return (c == ' ') || (c == '\t') || (c == '\r') ||
+             (c == '\v') || (c == '\f');
+    } // isBlank
+
+  public:
+
+    explicit GrammarScanner(string_view text, int firstLnr = 1)
+    : text(text), lnr(firstLnr) {
+    } // GrammarScanner
+
+    bool atEnd() const {
+      return pos >= text.size();
+    } // atEnd
+
+    string_view nextToken() { // next token in current line, empty at its end
+      while ( (pos < text.size()) && isBlank(text[pos]) )
+        pos++;
+      size_t start = pos;
+      while ( (pos < text.size()) && (text[pos] != '\n') && !isBlank(text[pos]) )
+        pos++;
+      return text.substr(start, pos - start);
+    } // nextToken
+
+    void skipLine() { // rest of current line, to start of next one
+      const void *nl = memchr(text.data() + pos, '\n', text.size() - pos);
+      if (nl == nullptr) {
+        pos = text.size();
+        return;
+      } // if
+      pos = static_cast<const char *>(nl) - text.data() + 1;
+      lineStart = pos;
+      lnr++;
+    } // skipLine
+
+    int lineNr() const { // of current line
+      return lnr;
+    } // lineNr
+
+    string position(string_view token) const { // of a token in current line
+      return "line " + to_string(lnr) + ", column " +
+             to_string(token.data() - (text.data() + lineStart) + 1);
+    } // position
+
+}; // GrammarScanner
+
+
+// === scanned grammars ================================================
+//
+// Result of the first phase of reading a grammar: the left-hand sides
+// are interned as NTs while scanning and the tokens of the right-hand
+// sides are recorded as views into the text or, if the text is only
+// available chunk by chunk, into copies of the tokens; after the last
+// rule all NTs are known, so the recorded tokens can be classified.
+
+struct GrammarBuilder::ScannedGrammar final {
+
+  struct RuleSpan {          // a line: nt -> tokens[first .. end)
+    NTSymbol *nt;
+    size_t first, end;
+  }; // RuleSpan
+
+  SymbolPool          sp;
+  string              rootNt;
+  vector<string_view> tokens;  // empty for "|"
+  vector<RuleSpan>    ruleSpans;
+  vector<NTSymbol *>  lhsNts;  // in order of rules
+  vector<bool>        isLhs;   // by symbol id, so no map of names is needed
+  bool firstNonEmptyLine = true;
+
+  const bool copyTokens;       // else tokens are views into the text
+  vector<unique_ptr<char[]>> blocks; // copies of tokens, never moved
+  char  *blockPos  = nullptr;
+  size_t blockRest = 0;
+
+  explicit ScannedGrammar(bool copyTokens) : copyTokens(copyTokens) {
+  } // ScannedGrammar
+
+  bool isLhsNt(const NTSymbol *ntSy) const {
+    return (ntSy != nullptr) &&
+           (ntSy->id < isLhs.size()) && isLhs[ntSy->id];
+  } // isLhsNt
+
+  string_view recorded(string_view token) { // token or a stable copy
+    if (!copyTokens)
+      return token;
+    if (token.length() > blockRest) {
+      blockRest = max(token.length(), size_t(1) << 16);
+      blocks.emplace_back(new char[blockRest]);
+      blockPos = blocks.back().get();
+    } // if
+    memcpy(blockPos, token.data(), token.length());
+    string_view copy(blockPos, token.length());
+    blockPos  += token.length();
+    blockRest -= token.length();
+    return copy;
+  } // recorded
+
+  // scans the lines of the scanner's text, false if "---" has been found
+  bool scan(GrammarScanner &scanner);
+
+}; // GrammarBuilder::ScannedGrammar
+
+bool GrammarBuilder::ScannedGrammar::scan(GrammarScanner &scanner) {
+  string_view sy;
+  for (; !scanner.atEnd(); scanner.skipLine()) {
+    sy = scanner.nextToken();
+    if (sy.empty() || sy.substr(0, 2) == "//") // skip empty or comment line
       continue;
     if (sy.substr(0, 3) == "---") // start of opt. symbol information: skip
-      break;
+      return false;
     if (firstNonEmptyLine) {     // sy should look like "G(...):"
       firstNonEmptyLine = false;
-      if ((sy.substr(0, 2) != "G(") ||
+      if ((sy.substr(0, 2) != "G(") || (sy.length() < 4) ||
         (sy.substr(sy.length() - 2, 2) != "):"))
-        throw runtime_error("grammar does not start with \"G(...):\"");
+        throw runtime_error("grammar does not start with \"G(...):\" in " +
+          scanner.position(sy));
       rootNt = sy.substr(2, sy.length() - 4);
       if ((rootNt == "") || (rootNt.length() > 20))
-        throw runtime_error("invalid root nonterminal \"" + rootNt + "\"");
-    } else {                     // additional non empty line, sy should be a nt
-      if (ntMap[sy] != nullptr)
-        throw runtime_error("duplicate nonterminal \"" + sy + "\"");
-      ntMap[sy] = sp.ntSymbol(sy);
-    } // else
-  } // while
+        throw runtime_error("invalid root nonterminal \"" + rootNt +
+          "\" in " + scanner.position(sy));
+      continue;
+    } // if
+    // additional non empty line, sy should be a nt
+    NTSymbol *ntSy = sp.ntSymbol(sy);
+    if (isLhsNt(ntSy))
+      throw runtime_error("duplicate nonterminal \"" + string(sy) +
+        "\" in " + scanner.position(sy));
+    if (ntSy->id >= isLhs.size())
+      isLhs.resize(ntSy->id + 1, false);
+    isLhs[ntSy->id] = true;
+    lhsNts.push_back(ntSy);
+    string_view arrow = scanner.nextToken();
+    if (arrow != "->")
+      throw runtime_error("syntax error in " + scanner.position(arrow) +
+        ": -> missing");
+    RuleSpan ruleSpan = {ntSy, tokens.size(), 0};
+    for (sy = scanner.nextToken(); !sy.empty(); sy = scanner.nextToken()) {
+      if (sy == "|")
+        tokens.push_back(string_view());
+      else if ((sy == "EPS") || (sy == "EPSILON") ||
+               (sy == "eps") || (sy == "epsilon"))
+        ; // nothing to do: seq is epsilon
+      else
+        tokens.push_back(recorded(sy));
+    } // for
+    ruleSpan.end = tokens.size();
+    ruleSpans.push_back(ruleSpan);
+  } // for
+  return true;
+} // GrammarBuilder::ScannedGrammar::scan
 
-  // 2. initialize Grammar object according to default constructor
-  root = ntMap[rootNt];
-  if (root == nullptr)
-    throw runtime_error("rule for root nonterminal \"" + rootNt +
-      "\" missing");
-  initialize(root);
 
-  // 3. re-read istream and generate terminals, sequences and rules
-  is.clear();                    // reset flags (especially eof and fail)
-  is.seekg(0);                   // rewind to the beginning
-  firstNonEmptyLine = true;
-  Sequence *seq = nullptr;
-  int lnr = 0;
-  while (!is.eof()) {
-    line = "";
-    getline(is, line);
-    if (is.fail())
+// reads the stream in a single pass, so it may be a non-seekable one,
+//   e.g., std::cin or a pipe: chunk by chunk, the complete lines are
+//   scanned at once and only a partial last line is carried over to
+//   the next chunk, so only the tokens are kept, not the whole text
+void GrammarBuilder::readGrammar(istream &is) {
+  const size_t chunkSize = size_t(1) << 16;
+  ScannedGrammar sg(true); // chunks are reused, so tokens are copied
+  string chunk;            // partial line carried over + next chunk
+  int lnr = 1;
+  bool atEnd = false;
+  while (!atEnd) {
+    const size_t carriedOver = chunk.size();
+    chunk.resize(carriedOver + chunkSize);
+    is.read(&chunk[carriedOver], chunkSize);
+    chunk.resize(carriedOver + static_cast<size_t>(is.gcount()));
+    atEnd = !is; // at end of stream the rest is the last line
+    const size_t lastNl = chunk.rfind('\n');
+    const size_t nrOfBytes = atEnd ? chunk.size() :
+                             (lastNl == string::npos) ? 0 : lastNl + 1;
+    GrammarScanner scanner(string_view(chunk).substr(0, nrOfBytes), lnr);
+    if (!sg.scan(scanner)) // "---": rest of stream is ignored
       break;
-    lnr++;
-    istringstream ls(line);      // line stream
-    sy = "";
-    ls >> sy;
-    if (sy == "" || sy.substr(0, 2) == "//")  // skip empty or comment line
+    lnr = scanner.lineNr();
+    chunk.erase(0, nrOfBytes);
+  } // while
+  readGrammar(sg);
+} // GrammarBuilder::readGrammar
+
+void GrammarBuilder::readGrammar(string_view text) {
+  ScannedGrammar sg(false); // text stays valid, so tokens are views
+  GrammarScanner scanner(text);
+  sg.scan(scanner);
+  readGrammar(sg);
+} // GrammarBuilder::readGrammar
+
+// classifies the recorded tokens as NTs or terminals and builds the rules
+void GrammarBuilder::readGrammar(const ScannedGrammar &sg) {
+  SymbolPool sp;
+
+  // 2. classify recorded tokens as nonterminals (left-hand sides of this
+  //   grammar) or terminals: only the NT for a name decides, as the name
+  //   may also be a T (an alias) from another grammar in the symbol pool
+  if (sg.firstNonEmptyLine)
+    throw runtime_error("grammar does not start with \"G(...):\", "
+                        "text is empty or has comments only");
+  NTSymbol *rootSy = sp.ntSymbolFor(sg.rootNt);
+  if (!sg.isLhsNt(rootSy))
+    throw runtime_error("rule for root nonterminal \"" + sg.rootNt +
+      "\" missing");
+  vector<Symbol *> symbols;     // per token, nullptr for "|"
+  symbols.reserve(sg.tokens.size());
+  vector<Symbol *> allSymbols(sg.lhsNts.begin(), sg.lhsNts.end()); // all NTs
+                                                                  //   and Ts, once
+  for (string_view token: sg.tokens) {
+    if (token.empty()) {        // "|"
+      symbols.push_back(nullptr);
       continue;
-    if (sy.substr(0, 3) == "---") // start of opt. symbol information
-      break;
-    if (firstNonEmptyLine) {     // sy should be "G(...):"
-      firstNonEmptyLine = false;
-      continue;                  // skip
     } // if
-    ntSy = sy;                   // non empty line starting with nt
-    arrowSy = "";
-    ls >> arrowSy;
-    if (arrowSy != "->") {
-      ostringstream lnrs;        // line number stream
-      lnrs << lnr;
-      throw runtime_error("syntax error in line " + lnrs.str() +
-        ": -> missing");
-    } // if
-    if (seq == nullptr)
-      seq = new Sequence();
-    while (!ls.eof()) {
-      sy = "";
-      ls >> sy;
-      if (sy == "|") {
-        addRule(ntMap[ntSy], seq);
-        seq = new Sequence();
-      } else if (sy != "") { // sy != "|" && sy != ""
-        if ((sy == "EPS") || (sy == "EPSILON") ||
-          (sy == "eps") || (sy == "epsilon"))
-          ; // nothing to do: seq is epsilon
-        else if (ntMap[sy] != nullptr) // sy is a nonterminal
-          seq->append(ntMap[sy]);
-        else {                   // sy is a terminal
-          if (tMap[sy] == nullptr)
-            tMap[sy] = sp.tSymbol(sy);
-          seq->append(tMap[sy]);
-        } // else
-      } // else
-    } // while
-    addRule(ntMap[ntSy], seq);
-    seq = nullptr;
-  } // while
+    NTSymbol *ntSy = sp.ntSymbolFor(token);
+    if (sg.isLhsNt(ntSy))       // token is a nonterminal
+      symbols.push_back(ntSy);
+    else {                      // token is a terminal
+      TSymbol *tSy = sp.tSymbol(token);
+      if (!v.contains(tSy)) {   // v marks the terminals seen so far
+        v.insert(tSy);
+        allSymbols.push_back(tSy);
+      } // if
+      symbols.push_back(tSy);
+    } // else
+  } // for
+  v.clear();
+
+  // 3. all symbols are inserted into the vocabularies in sorted order,
+  //   so each insertion appends and the later ones find them in O(1)
+  sort(allSymbols.begin(), allSymbols.end(), LessForSymbolPtrs());
+  for (Symbol *sy: allSymbols)
+    if (sy->isNT())
+      insertIntoVNt(asNT(sy));
+    else
+      insertIntoVT(asT(sy));
+  initialize(rootSy);
+
+  // 4. generate sequences and rules, alternatives are built in one
+  //   scratch sequence and copied only if they are new ones
+  Sequence seq;
+  for (const ScannedGrammar::RuleSpan &ruleSpan: sg.ruleSpans) {
+    seq.clear();
+    for (size_t i = ruleSpan.first; i < ruleSpan.end; i++) {
+      if (symbols[i] == nullptr) { // "|"
+        addRule(ruleSpan.nt, seq);
+        seq.clear();
+      } else
+        seq.push_back(symbols[i]);
+    } // for
+    addRule(ruleSpan.nt, seq);
+  } // for
 } // GrammarBuilder::readGrammar
 
 
 bool GrammarBuilder::insertIntoVNt(NTSymbol *ntSy) {
+  if (v.contains(ntSy)) // fast path via bitset
+    return false;
   Symbol *sy = v.symbolFor(ntSy->name);
   if (sy != nullptr) {
     if (sy->isT())
       throw invalid_argument("name clash for NT: a T already named \"" +
-        ntSy->name + "\"");
+        string(ntSy->name) + "\"");
     return false;
   } else { // sy == nullptr
     vNt.insert(ntSy);
@@ -146,11 +420,13 @@ bool GrammarBuilder::insertIntoVNt(NTSymbol *ntSy) {
 } // GrammarBuilder::insertIntoVNt
 
 bool GrammarBuilder::insertIntoVT(TSymbol *tSy) {
+  if (v.contains(tSy)) // fast path via bitset
+    return false;
   Symbol *sy = v.symbolFor(tSy->name);
   if (sy != nullptr) {
     if (sy->isNT())
       throw invalid_argument("name clash for T: a NT already named \"" +
-        tSy->name + "\"");
+        string(tSy->name) + "\"");
     return false;
   } else { // sy == nullptr
     vT.insert(tSy);
@@ -166,15 +442,17 @@ GrammarBuilder::GrammarBuilder(NTSymbol *root) {
 } // GrammarBuilder::GrammarBuilder
 
 GrammarBuilder::GrammarBuilder(const string &fileName) {
-  ifstream ifs(fileName);
-  if (!ifs.good())
-    throw invalid_argument("file \"" + fileName + "\" not found");
-  readGrammar(ifs);
+  const FileText fileText(fileName); // mapped, so scanned without copying
+  readGrammar(fileText.text());
 } //GrammarBuilder::GrammarBuilder
 
+GrammarBuilder::GrammarBuilder(istream &is) {
+  readGrammar(is);
+} // GrammarBuilder::GrammarBuilder
+
 GrammarBuilder::GrammarBuilder(const char *grammarStr) {
-  istringstream iss(string(grammarStr, strlen(grammarStr)));
-  readGrammar(iss);
+  checkForNullptr(const_cast<char *>(grammarStr), "invalid nullptr for grammar string");
+  readGrammar(string_view(grammarStr)); // no copy of the string
 } // GrammarBuilder::GrammarBuilder
 
 
@@ -189,15 +467,23 @@ bool GrammarBuilder::addRule(NTSymbol *nt, Sequence *seq) {
   } else { // grammar takes ownership of seq
     for (Symbol *sy: *seq) {
       if (sy->isT())
-        insertIntoVT(dynamic_cast<TSymbol *>(sy));
+        insertIntoVT(asT(sy));
       else // sy->isNT()
-        insertIntoVNt(dynamic_cast<NTSymbol *>(sy));
+        insertIntoVNt(asNT(sy));
     } // for
     return true; // seq inserted
   } // else
 } // GrammarBuilder::addRule
 
 
+bool GrammarBuilder::addRule(NTSymbol *nt, const Sequence &seq) {
+  checkForNullptr(nt, "invalid nullptr for nonterminal");
+  auto it = rules.find(nt);
+  if ( (it != rules.end()) && it->second.contains(seq) )
+    return false; // duplicate, so no copy
+  return addRule(nt, new Sequence(seq));
+} // GrammarBuilder::addRule
+
 void GrammarBuilder::addRule(NTSymbol *nt, initializer_list<Sequence *> seqs) {
   for (auto seq: seqs) {
     checkForNullptr(seq, "invalid nullptr for sequence");
@@ -212,26 +498,54 @@ void  GrammarBuilder::setNewRoot(NTSymbol *newRoot) {
 } //  GrammarBuilder::setNewRoot
 
 
-Grammar *GrammarBuilder::buildGrammar()  const {
+void GrammarBuilder::checkRules() const {
   // 1. check if root nonterminal has a rule
   if (rules.find(root) == rules.end())
     throw invalid_argument("root nonterminal \"" +
-                           root->name + "\" has no rule");
-  // 2. check if all other nonterminals also have rules
+                           string(root->name) + "\" has no rule");
+  // 2. check if all other nonterminals also have rules, in a single
+  //   scan over all rules with a bitset by symbol id for the NTs that
+  //   have a rule, so no map lookup per occurrence of an NT
+  vector<bool> hasRule;
+  for (auto &rule: rules) {
+    if (rule.first->id >= hasRule.size())
+      hasRule.resize(rule.first->id + 1, false);
+    hasRule[rule.first->id] = true;
+  } // for
   for (auto &rule: rules) {
     for (Sequence *seq: rule.second) {
       for (Symbol *sy: *seq) {
-        if (sy->isNT() && sy != root) {
-          NTSymbol *nt = dynamic_cast<NTSymbol *>(sy);
-          if (rules.find(nt) == rules.end())
-            throw invalid_argument("nonterminal \"" +
-                                   nt->name + "\" has no rule");
-        } // if
+        if ( sy->isNT() &&
+             ((sy->id >= hasRule.size()) || !hasRule[sy->id]) )
+          throw invalid_argument("nonterminal \"" +
+                                 string(sy->name) + "\" has no rule");
       } // for
     } // for
   } // for
-  // 3. build the Grammar object
-  return new Grammar(root, rules, vNt, vT, v);
+} // GrammarBuilder::checkRules
+
+
+Grammar *GrammarBuilder::buildGrammar() const & {
+  checkRules();
+  RulesMap sortedRules; // with copies of all sequences
+  for (auto &rule: rules) {
+    vector<Sequence *> seqs;
+    seqs.reserve(rule.second.size());
+    for (const Sequence *seq: rule.second)
+      seqs.push_back(new Sequence(*seq));
+    sortedRules.emplace(rule.first, SequenceSet(std::move(seqs))); // sorts once
+  } // for
+  return new Grammar(root, std::move(sortedRules), VNt(vNt), VT(vT), V(v));
+} // GrammarBuilder::buildGrammar
+
+Grammar *GrammarBuilder::buildGrammar() && {
+  checkRules();
+  RulesMap sortedRules; // takes over all sequences
+  for (auto &rule: rules)
+    sortedRules.emplace(rule.first, SequenceSet(rule.second.release())); // sorts once
+  rules.clear();
+  return new Grammar(root, std::move(sortedRules), std::move(vNt),
+                           std::move(vT),          std::move(v));
 } // GrammarBuilder::buildGrammar
 
 
@@ -11,6 +11,7 @@
 #include <iosfwd>
 #include <map>
 #include <string>
+#include <string_view>
 
 #include "ObjectCounter.h"
 #include "SymbolStuff.h"
@@ -34,31 +35,44 @@ class GrammarBuilder final // no public base class
     SymbolPool sp;
 
     // data components: same as in class Grammar but all non-const
+    //   and with unordered alternatives in rules
 
-    NTSymbol *root;     // no ownership: SymbolPool is the owner of all symbols
-    RulesMap  rules;    // has at least an empty rule for root
-    VNt       vNt;      // all nonterminals for rules, including root
-    VT        vT;       // all terminals occuring in rules
-    V         v;        // all symbols, union of vNt and vT
+    NTSymbol          *root;  // no ownership: SymbolPool is the owner of all symbols
+    UnorderedRulesMap  rules; // has at least an empty rule for root
+    VNt                vNt;   // all nonterminals for rules, including root
+    VT                 vT;    // all terminals occuring in rules
+    V                  v;     // all symbols, union of vNt and vT
 
     void initialize(NTSymbol *root);    // do first part of constructors work
 
-    void readGrammar(std::istream &is); // init. rest of grammar from stream,
+    struct ScannedGrammar; // rules scanned from text, see GrammarBuilder.cpp
+
+    void readGrammar(std::istream &is); // init. rest of grammar from stream
+      // in a single pass, chunk by chunk, so is need not be seekable
+    void readGrammar(std::string_view text); // for whole texts, e.g.,
+      // memory-mapped files, scanned without copying,
+      // both with errors with line and column and
       // syntax as generatd by operator<< with one rule/line and one line/rule:
       //   G(S):
       //   S -> seq1 | seq2 | ...
       //   A -> seq3 | ...
       // where seqs are sequences of terminal- and/or nonterminals
+    void readGrammar(const ScannedGrammar &sg); // rest of work of both
 
     bool insertIntoVNt(NTSymbol *ntSy); // true if inserted else sy is a duplicate
     bool insertIntoVT (TSymbol  *tSy);  // true if inserted else sy is a duplicate
 
+    void checkRules() const; // throws if root or another nonterminal has no rule
+
   public:
 
     GrammarBuilder(NTSymbol *root); // empty builder, needs programmatical init.
 
-    GrammarBuilder(const std::string &fileName); // init. with contents of text file
+    GrammarBuilder(const std::string &fileName); // init. with contents of text file,
+                                                 //   memory-mapped if possible
     GrammarBuilder(const char        *str);      // init. with C string
+    GrammarBuilder(std::istream      &is);       // init. with contents of stream,
+                                                 //   read once, e.g., from std::cin
 
     GrammarBuilder(const GrammarBuilder &gb) = delete;
     GrammarBuilder &operator==(const GrammarBuilder &gb) = delete;
@@ -72,12 +86,20 @@ class GrammarBuilder final // no public base class
       //   true  if seq was a new one, that has been added
       //   false if seq was a duplicate, so addRule deleted seq
 
+    bool addRule(NTSymbol *nt, const Sequence &seq); // inserts a copy ...
+      // ... of seq, allocated only if seq is not a duplicate, returns
+      //   true  if the copy has been added
+      //   false if seq was a duplicate
+
     void addRule(NTSymbol *nt, std::initializer_list<Sequence *> seqs);
 
     void setNewRoot(NTSymbol *newRoot);
 
-    // main method to build new Grammar object
-    Grammar *buildGrammar() const;
+    // main methods to build new Grammar object, the latter for
+    //   std::move(gb).buildGrammar() hands all rules over to the grammar
+    //   without copying them and leaves the builder empty
+    Grammar *buildGrammar() const &;
+    Grammar *buildGrammar() &&;
 
 }; // GrammarBuilder
 
@@ -0,0 +1,298 @@
+// GrammarTransformations.cpp:
+// --------------------------
+// Transformations of grammars into new, equivalent grammars.
+//======================================================================
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#include "SymbolStuff.h"
+#include "SequenceStuff.h"
+#include "GrammarBuilder.h"
+#include "GrammarTransformations.h"
+
+
+// === reduction =======================================================
+
+ostream &operator<<(ostream &os, const ReductionReport &rr) {
+  os << "unproductive NTs: " << rr.unproductiveNTs << endl;
+  os << "unreachable NTs:  " << rr.unreachableNTs  << endl;
+  os << "unused Ts:        " << rr.unusedTs        << endl;
+  os << "removed alternatives: " << rr.nrOfRemovedAlternatives << endl;
+  return os;
+} // operator<<
+
+
+Grammar *newReducedGrammar(const Grammar *g, ReductionReport *report) {
+  checkForNullptr(const_cast<Grammar *>(g), "invalid nullptr for grammar");
+  const VNt &productive = g->productiveNTs(); // with a worklist, cached
+  if (!productive.contains(g->root))
+    throw domain_error("root nonterminal \"" + string(g->root->name) +
+                       "\" is unproductive, language is empty");
+
+  auto isUseful = [&productive](const Sequence *seq) {
+    for (const Symbol *sy: *seq)
+      if (sy->isNT() && !productive.contains(asNT(sy)))
+        return false;
+    return true;
+  };
+
+  // 1. NTs reachable from root via alternatives without unproductive NTs,
+  //   with a worklist and a bitset by symbol id
+  vector<bool> reached;
+  auto reach = [&reached](NTSymbol *nt) { // true if nt is new
+    if (nt->id >= reached.size())
+      reached.resize(nt->id + 1, false);
+    if (reached[nt->id])
+      return false;
+    reached[nt->id] = true;
+    return true;
+  };
+  auto isReached = [&reached](const NTSymbol *nt) {
+    return (nt->id < reached.size()) && reached[nt->id];
+  };
+  vector<NTSymbol *> worklist;
+  reach(g->root);
+  worklist.push_back(g->root);
+  while (!worklist.empty()) {
+    NTSymbol *nt = worklist.back();
+    worklist.pop_back();
+    for (const Sequence *seq: g->rules[nt]) // non-inserting for const map
+      if (isUseful(seq))
+        for (Symbol *sy: *seq)
+          if (sy->isNT() && reach(asNT(sy)))
+            worklist.push_back(asNT(sy));
+  } // while
+
+  // 2. copies of the useful alternatives of reached NTs
+  GrammarBuilder gb(g->root);
+  int nrOfRemovedAlternatives = 0;
+  for (auto &rule: g->rules) {
+    if (!isReached(rule.first)) {
+      nrOfRemovedAlternatives += static_cast<int>(rule.second.size());
+      continue;
+    } // if
+    for (const Sequence *seq: rule.second)
+      if (isUseful(seq))
+        gb.addRule(rule.first, new Sequence(*seq));
+      else
+        nrOfRemovedAlternatives++;
+  } // for
+  Grammar *reduced = std::move(gb).buildGrammar();
+
+  if (report != nullptr) {
+    report->unproductiveNTs = g->vNt - productive;
+    report->unreachableNTs  = g->vNt - report->unproductiveNTs - reduced->vNt;
+    report->unusedTs        = g->vT  - reduced->vT;
+    report->nrOfRemovedAlternatives = nrOfRemovedAlternatives;
+  } // if
+  return reduced;
+} // newReducedGrammar
+
+
+// === epsilon-free grammars ===========================================
+
+// is name free in used, i.e. neither the NT nor the T (an alias) for
+//   name is used, symbols for name in the pool only may be reused
+static bool isFree(const V &used, const string &name) {
+  SymbolPool sp;
+  const NTSymbol *nt = sp.ntSymbolFor(name);
+  const  TSymbol *t  = sp. tSymbolFor(name);
+  return ( (nt == nullptr) || !used.contains(nt) ) &&
+         ( (t  == nullptr) || !used.contains(t ) );
+} // isFree
+
+// new NT for name or, if name is already used, for the first one of
+//   name + "'", name + "''", ... that is not, which becomes used then
+static NTSymbol *newNtFor(V &used, string name) {
+  SymbolPool sp;
+  for (;;) {
+    if (isFree(used, name)) {
+      NTSymbol *nt = sp.ntSymbol(name);
+      used.insert(nt);
+      return nt;
+    } // if
+    name += "'";
+  } // for
+} // newNtFor
+
+// new NT for a piece of an alternative of nt: nt'1, nt'2, ... with
+//   numbers counted by nr for all NTs
+static NTSymbol *newHelperNtFor(V &used, const NTSymbol *nt, int &nr) {
+  SymbolPool sp;
+  for (;;) {
+    string name = string(nt->name) + "'" + to_string(++nr);
+    if (isFree(used, name)) {
+      NTSymbol *h = sp.ntSymbol(name);
+      used.insert(h);
+      return h;
+    } // if
+  } // for
+} // newHelperNtFor
+
+// adds all nonempty variants of rhs[0 .. n) without subsets of the
+//   occurrences at the positions in dels to the rule for nt: bit i of
+//   mask omits the occurrence at dels[i], each variant is built in the
+//   scratch sequence and copied only if it is a new alternative;
+//   dels.size() <= maxMaxDeletablesPerAlternative, so the mask fits
+static void addVariants(GrammarBuilder &gb, NTSymbol *nt,
+                        Symbol *const *rhs, int n,
+                        const vector<int> &dels, Sequence &scratch) {
+  const unsigned long nrOfVariants = 1UL << dels.size();
+  for (unsigned long mask = 0; mask < nrOfVariants; mask++) {
+    scratch.clear();
+    size_t d = 0; // index into dels
+    for (int i = 0; i < n; i++)
+      if ( (d < dels.size()) && (dels[d] == i) ) {
+        if (((mask >> d) & 1) == 0)
+          scratch.push_back(rhs[i]);
+        d++;
+      } else
+        scratch.push_back(rhs[i]);
+    if (!scratch.empty())
+      gb.addRule(nt, scratch); // copies new alternatives only
+  } // for
+} // addVariants
+
+
+// NTs deriving epsilon only (by symbol id): deletable NTs that do not
+//   derive a nonempty sequence, i.e., one with a terminal; the latter are
+//   computed with a worklist as in the analyses of Grammar: NTs with a
+//   terminal in one of their alternatives and then, along the
+//   occurrences, the left-hand sides of the alternatives containing one
+static vector<bool> epsilonOnlyNTsOf(const Grammar *g) {
+  Symbol::Id maxId = 0;
+  for (const NTSymbol *nt: g->vNt)
+    maxId = max(maxId, nt->id);
+
+  // 1. per NT, the left-hand sides of its occurrences (as compressed
+  //   rows), and NTs with a terminal in an alternative
+  vector<bool> nonEmpty(maxId + 1, false);
+  vector<NTSymbol *> worklist; // NTs in nonEmpty, not processed yet
+  vector<int> occStart(maxId + 2, 0);
+  for (auto &rule: g->rules)
+    for (const Sequence *seq: rule.second) {
+      if ( (seq->terminalLength() > 0) && !nonEmpty[rule.first->id] ) {
+        nonEmpty[rule.first->id] = true;
+        worklist.push_back(rule.first);
+      } // if
+      for (const Symbol *sy: *seq)
+        if (sy->isNT())
+          occStart[sy->id + 1]++;
+    } // for
+  for (Symbol::Id id = 0; id <= maxId; id++)
+    occStart[id + 1] += occStart[id];
+  vector<NTSymbol *> lhsOfOcc(occStart.back());
+  vector<int> occEnd(occStart.begin(), occStart.end() - 1);
+  for (auto &rule: g->rules)
+    for (const Sequence *seq: rule.second)
+      for (const Symbol *sy: *seq)
+        if (sy->isNT())
+          lhsOfOcc[occEnd[sy->id]++] = rule.first;
+
+  // 2. propagate along the occurrences
+  while (!worklist.empty()) {
+    const NTSymbol *nt = worklist.back();
+    worklist.pop_back();
+    for (int o = occStart[nt->id]; o < occStart[nt->id + 1]; o++)
+      if (!nonEmpty[lhsOfOcc[o]->id]) {
+        nonEmpty[lhsOfOcc[o]->id] = true;
+        worklist.push_back(lhsOfOcc[o]);
+      } // if
+  } // while
+
+  vector<bool> epsilonOnly(maxId + 1, false);
+  for (NTSymbol *nt: g->deletableNTs())
+    epsilonOnly[nt->id] = !nonEmpty[nt->id];
+  return epsilonOnly;
+} // epsilonOnlyNTsOf
+
+
+Grammar *newEpsilonFreeGrammar(const Grammar *g,
+                               int maxDeletablesPerAlternative) {
+  checkForNullptr(const_cast<Grammar *>(g), "invalid nullptr for grammar");
+  if ( (maxDeletablesPerAlternative < 2) ||
+       (maxDeletablesPerAlternative > maxMaxDeletablesPerAlternative) )
+    throw invalid_argument("maxDeletablesPerAlternative must be in [2, " +
+                           to_string(maxMaxDeletablesPerAlternative) + "]");
+  const VNt &deletable = g->deletableNTs();
+
+  // NTs deriving epsilon only, also via other NTs, do not have a rule
+  //   any more, so their occurrences are omitted in all variants
+  const vector<bool> epsilonOnly = epsilonOnlyNTsOf(g);
+  auto isEpsilonOnly = [&epsilonOnly](const Symbol *sy) {
+    return sy->isNT() && (sy->id < epsilonOnly.size()) && epsilonOnly[sy->id];
+  };
+  auto isDeletable = [&deletable](const Symbol *sy) {
+    return sy->isNT() && deletable.contains(asNT(sy));
+  };
+
+  V used = g->v; // names of new NTs must not be used in g
+  NTSymbol *newRoot = nullptr;
+  if (deletable.contains(g->root))
+    newRoot = newNtFor(used, string(g->root->name) + "'");
+  GrammarBuilder gb(newRoot != nullptr ? newRoot : g->root);
+  int nrOfHelpers = 0;
+
+  Sequence scratch;          // for all variants
+  vector<Symbol *> rhs;      // right-hand side of the current piece
+  vector<int> dels;          // positions of deletable occurrences in rhs
+  for (auto &rule: g->rules) {
+    if (isEpsilonOnly(rule.first))
+      continue; // all variants are empty
+    for (const Sequence *seq: rule.second) {
+      // split seq into pieces with at most maxDeletablesPerAlternative
+      //   deletable occurrences: A -> piece A'1, A'1 -> next piece, ...
+      NTSymbol *lhs = rule.first; // lhs -> piece ...
+      int nrOfDels = 0;          // deletable occurrences in rest of seq
+      for (Symbol *sy: *seq)
+        if (isDeletable(sy) && !isEpsilonOnly(sy))
+          nrOfDels++;
+      rhs.clear();
+      dels.clear();
+      auto it = seq->begin();
+      while (it != seq->end()) {
+        Symbol *sy = *it++;
+        if (isEpsilonOnly(sy))
+          continue;
+        if (isDeletable(sy)) {
+          dels.push_back(static_cast<int>(rhs.size()));
+          nrOfDels--;
+        } // if
+        rhs.push_back(sy);
+        if ( (static_cast<int>(dels.size()) == maxDeletablesPerAlternative - 1) &&
+             (nrOfDels > 1) ) { // more than one left: split
+          NTSymbol *h = newHelperNtFor(used, rule.first, nrOfHelpers);
+          bool hIsDeletable = all_of(it, seq->end(), isDeletable);
+          if (hIsDeletable)
+            dels.push_back(static_cast<int>(rhs.size()));
+          rhs.push_back(h);
+          addVariants(gb, lhs, rhs.data(), static_cast<int>(rhs.size()),
+                      dels, scratch);
+          lhs = h;
+          rhs.clear();
+          dels.clear();
+        } // if
+      } // while
+      addVariants(gb, lhs, rhs.data(), static_cast<int>(rhs.size()),
+                  dels, scratch);
+    } // for
+  } // for
+
+  if (newRoot != nullptr) { // root' -> root | EPS
+    if (!isEpsilonOnly(g->root))
+      gb.addRule(newRoot, Sequence(g->root));
+    gb.addRule(newRoot, Sequence());
+  } // if
+  return std::move(gb).buildGrammar(); // builder not used any more
+} // newEpsilonFreeGrammar
+
+
+// end of GrammarTransformations.cpp
+//======================================================================
@@ -0,0 +1,54 @@
+// GrammarTransformations.h:
+// ------------------------
+// Transformations of grammars into new, equivalent grammars, which are
+// built with GrammarBuilder; the original grammars remain unchanged.
+//======================================================================
+
+#ifndef GrammarTransformations_h
+#define GrammarTransformations_h
+
+#include <iosfwd>
+
+#include "Vocabulary.h"
+#include "GrammarBasics.h"
+#include "Grammar.h"
+
+
+// what newReducedGrammar removed from the original grammar
+struct ReductionReport {
+  VNt unproductiveNTs; // derive no terminal sequence, with their rules
+  VNt unreachableNTs;  // productive, but not reachable from root
+  VT  unusedTs;        // terminals occurring in removed alternatives only
+  int nrOfRemovedAlternatives = 0; // of all removed NTs, too
+}; // ReductionReport
+
+std::ostream &operator<<(std::ostream &os, const ReductionReport &rr);
+
+
+// reduced grammar without useless symbols: unproductive NTs with the
+//   alternatives they occur in and then unreachable NTs are removed,
+//   both analyses are linear in the size of g; if report != nullptr
+//   it receives what has been removed; throws domain_error if root is
+//   unproductive, i.e., the language of g is empty
+Grammar *newReducedGrammar(const Grammar *g, ReductionReport *report = nullptr);
+
+
+// each piece of an alternative with n deletable occurrences has 2^n variants
+const int maxMaxDeletablesPerAlternative = 16;
+
+// epsilon-free grammar: alternatives with deletable NTs are replaced by
+//   all their nonempty variants without subsets of these NT occurrences,
+//   epsilon alternatives are removed; if root is deletable, a new root
+//   root' -> root | EPS is introduced; to keep the growth linear,
+//   alternatives with more than maxDeletablesPerAlternative deletable
+//   occurrences are split into a chain of new NTs with shorter ones;
+//   NTs deriving epsilon only are removed with all their occurrences;
+//   throws invalid_argument unless 2 <= maxDeletablesPerAlternative <=
+//   maxMaxDeletablesPerAlternative
+Grammar *newEpsilonFreeGrammar(const Grammar *g,
+                               int maxDeletablesPerAlternative = 4);
+
+#endif
+
+// end of GrammarTransformations.h
+//======================================================================
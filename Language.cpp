@@ -1,8 +1,10 @@
 #include "Language.h"
+#include "CompiledGrammar.h"
 
 #include <algorithm>
+#include <memory>
 #include <queue>
-#include <set>
+#include <utility>
 
 Language::Language() = default;
 
@@ -10,68 +12,174 @@ Language::~Language() = default;
 
 Language::Language(Language &&l) noexcept = default;
 
-const std::vector<Sequence> &Language::getSequences() const {
+std::vector<Sequence> Language::getSequences() const {
+    std::vector<Sequence> sequences;
+    sequences.reserve(sentences.size());
+    for (std::size_t i = 0; i < sentences.size(); i++) {
+        sequences.push_back(sentences.sequenceAt(i));
+    }
     return sequences;
 }
 
-Sequence createFullSequence(const Sequence &currentSequence, const std::vector<const Symbol *> &symbolsToExpand) {
-    Sequence fullSequence = currentSequence;
-    for (const Symbol *symbol: symbolsToExpand) {
-        fullSequence.append(const_cast<Symbol *>(symbol));
+std::size_t Language::size() const {
+    return sentences.size();
+}
+
+std::size_t Language::nrOfBytes() const {
+    return sentences.nrOfBytes();
+}
+
+namespace {
+
+// The sentential forms of the BFS below are persistent: a form shares all
+// nodes of the form it has been derived from and adds at most one node,
+// so memory and time per expanded form are constant.
+
+// Productions are alternatives of the compiled grammar, i.e., flat rows of
+// tagged symbol indices, see CompiledGrammar.h.
+using Tagged = CompiledGrammar::Tagged;
+
+// terminal prefix, linked backwards, so appending a terminal is O(1)
+struct PrefixNode {
+    Tagged symbol = 0;
+    const PrefixNode *previous = nullptr;
+};
+
+// pending symbols as a stack of productions, so pushing a production is O(1);
+// popping a symbol only advances the position of the form in its top production
+struct PendingNode {
+    const Tagged *production = nullptr;
+    int productionLength = 0;
+    const PendingNode *next = nullptr; // production below and ...
+    int nextPosition = 0;              // ... position to continue there
+};
+
+struct SententialForm {
+    const PrefixNode *prefix;   // nullptr for the empty prefix
+    const PendingNode *pending; // nullptr if there are no pending symbols
+    int pendingPosition;        // next symbol in pending->production
+    int prefixLength;
+    int pendingLength;
+    int nrOfPendingNTs;
+};
+
+// all nodes of one enumeration are allocated in blocks and released together
+template<typename NodeT>
+class NodeArena {
+public:
+    const NodeT *newNode(const NodeT &node) {
+        if (nrOfUsedNodes == blockSize) {
+            blocks.push_back(std::make_unique<NodeT[]>(blockSize));
+            nrOfUsedNodes = 0;
+        }
+        NodeT *newNode = &blocks.back()[nrOfUsedNodes++];
+        *newNode = node;
+        return newNode;
+    }
+
+private:
+    static constexpr std::size_t blockSize = 4096;
+    std::vector<std::unique_ptr<NodeT[]> > blocks;
+    std::size_t nrOfUsedNodes = blockSize;
+};
+
+// the form without its top pending symbol
+SententialForm popped(SententialForm form) {
+    if (form.pendingPosition + 1 < form.pending->productionLength) {
+        form.pendingPosition++;
+    } else {
+        form.pendingPosition = form.pending->nextPosition;
+        form.pending = form.pending->next;
+    }
+    form.pendingLength--;
+    return form;
+}
+
+// prefix followed by the pending symbols
+Sequence toSequence(const CompiledGrammar &cg, const SententialForm &form) {
+    Sequence sequence;
+    sequence.reserve(form.prefixLength + form.pendingLength);
+    for (const PrefixNode *node = form.prefix; node != nullptr; node = node->previous) {
+        sequence.push_back(cg.symbolOf(node->symbol));
+    }
+    std::reverse(sequence.begin(), sequence.end());
+    for (SententialForm rest = form; rest.pending != nullptr; rest = popped(rest)) {
+        sequence.push_back(cg.symbolOf(rest.pending->production[rest.pendingPosition]));
+    }
+    return sequence;
+}
+
+// Alternatives without unproductive NTs, by alternative index: expanding the
+// others never leads to a sentence
+std::vector<bool> productiveAlternativesOf(const CompiledGrammar &cg) {
+    const std::vector<bool> productive = cg.productiveNts();
+    std::vector<bool> alternatives(cg.nrOfAlternatives());
+    for (std::uint32_t a = 0; a < cg.nrOfAlternatives(); a++) {
+        alternatives[a] = std::all_of(cg.begin(a), cg.end(a), [&productive](Tagged sy) {
+            return CompiledGrammar::isT(sy) || productive[CompiledGrammar::idxOfTagged(sy)];
+        });
     }
-    return fullSequence;
+    return alternatives;
 }
+}
+
+void processNonTerminalSymbols(const CompiledGrammar &cg, PackedSequenceSet &allSequences, const int maxLen) {
+    NodeArena<PrefixNode> prefixNodes;
+    NodeArena<PendingNode> pendingNodes;
+    const auto productiveAlternatives = productiveAlternativesOf(cg);
 
-void processNonTerminalSymbols(const NTSymbol *rootSymbol, const Grammar *g, std::set<Sequence> &allSequences,
-                               const int maxLen) {
-    std::queue<std::pair<Sequence, std::vector<const Symbol *> > > queue;
-    queue.push({Sequence(), {rootSymbol}});
+    const Tagged rootSequence[] = {(0 << 1) | 1}; // root has NT index 0
+    std::queue<SententialForm> queue;
+    queue.push({nullptr, pendingNodes.newNode({rootSequence, 1, nullptr, 0}), 0, 0, 1, 1});
 
     while (!queue.empty()) {
-        auto currentSequence = queue.front().first;
-        auto symbolsToExpand = queue.front().second;
+        const SententialForm form = queue.front();
         queue.pop();
 
-        // Step 1: Check if the current sequence contains only terminal symbols
-        const bool isFullyTerminal = std::all_of(
-            symbolsToExpand.begin(),
-            symbolsToExpand.end(),
-            [](const Symbol *symbol) { return symbol->isT(); });
+        // Step 1: Check if the pending symbols are terminal symbols only
+        const bool isFullyTerminal = form.nrOfPendingNTs == 0;
 
         // Step 2: If fully terminal and within maxLen, add it to results and skip further expansion
-        if (isFullyTerminal && currentSequence.length() + symbolsToExpand.size() <= maxLen) {
-            allSequences.insert(createFullSequence(currentSequence, symbolsToExpand));
+        if (isFullyTerminal && form.prefixLength + form.pendingLength <= maxLen) {
+            allSequences.insert(toSequence(cg, form)); // packs it
             continue;
         }
 
         // Step 3: Stop expanding if the length constraint is reached
-        if (currentSequence.length() >= maxLen) {
+        if (form.prefixLength >= maxLen) {
             continue;
         }
 
-        // Step 4: Expand the next symbol in `symbolsToExpand` list if not empty
-        if (!symbolsToExpand.empty()) {
-            const Symbol *nextSymbol = symbolsToExpand.front();
-            std::vector<const Symbol *> remainingSymbols(symbolsToExpand.begin() + 1, symbolsToExpand.end());
+        // Step 4: Expand the next pending symbol if there is one
+        if (form.pending != nullptr) {
+            const Tagged nextSymbol = form.pending->production[form.pendingPosition];
+            SententialForm rest = popped(form);
 
-            if (nextSymbol->isT()) {
+            if (CompiledGrammar::isT(nextSymbol)) {
                 // Append terminal symbol and continue expanding remaining symbols
-                Sequence newSequence(currentSequence);
-                newSequence.append(const_cast<Symbol *>(nextSymbol));
-                queue.emplace(newSequence, remainingSymbols);
+                rest.prefix = prefixNodes.newNode({nextSymbol, form.prefix});
+                rest.prefixLength++;
+                queue.push(rest);
             } else {
                 // Expand non-terminal by exploring its production rules
-                const auto &currentSequenceSet = g->rules.find(
-                    const_cast<NTSymbol *>(dynamic_cast<const NTSymbol *>(nextSymbol)))->second;
-
-                for (const Sequence *productionSeq: currentSequenceSet) {
-                    Sequence newSequence(currentSequence);
-                    std::vector<const Symbol *> newSymbolsToExpand(remainingSymbols);
-
-                    // Add symbols of this production to the front of remaining symbols
-                    newSymbolsToExpand.insert(newSymbolsToExpand.begin(), productionSeq->begin(), productionSeq->end());
-
-                    queue.emplace(newSequence, newSymbolsToExpand);
+                const std::uint32_t nt = CompiledGrammar::idxOfTagged(nextSymbol);
+                rest.nrOfPendingNTs--;
+
+                for (std::uint32_t a = cg.firstAlt(nt); a < cg.endAlt(nt); a++) {
+                    if (!productiveAlternatives[a]) {
+                        continue;
+                    }
+                    // Push this production onto the remaining symbols
+                    SententialForm expanded = rest;
+                    const int length = cg.length(a);
+                    if (length > 0) {
+                        expanded.pending = pendingNodes.newNode({cg.begin(a), length, rest.pending, rest.pendingPosition});
+                        expanded.pendingPosition = 0;
+                        expanded.pendingLength += length;
+                        expanded.nrOfPendingNTs += static_cast<int>(
+                            std::count_if(cg.begin(a), cg.end(a), CompiledGrammar::isNT));
+                    }
+                    queue.push(expanded);
                 }
             }
         }
@@ -80,27 +188,22 @@ void processNonTerminalSymbols(const NTSymbol *rootSymbol, const Grammar *g, std
 
 // Adjust the languageOf function to use the BFS version of processNonTerminal
 Language Language::languageOf(const Grammar *g, const int maxLen) {
-    Language language;
-    const auto *root = g->root;
-    std::set<Sequence> allSequences;
+    return languageOf(g->compiled(), maxLen); // compiled once per grammar
+}
 
-    // Generate sequences using breadth-first expansion
-    processNonTerminalSymbols(root, g, allSequences, maxLen);
+Language Language::languageOf(const CompiledGrammar &cg, const int maxLen) {
+    Language language;
 
-    // Copy valid sequences into the language object
-    for (const auto &seq: allSequences) {
-        language.sequences.emplace_back(seq);
-    }
+    // Generate sequences using breadth-first expansion, they are packed and
+    // deduplicated in the language object and sorted only once at the end
+    processNonTerminalSymbols(cg, language.sentences, maxLen);
+    language.sentences.sort();
 
     return language;
 }
 
 bool Language::hasSentence(const Sequence &s) const {
-    return std::any_of(
-        sequences.begin(),
-        sequences.end(),
-        [&s](const Sequence &seq) { return seq == s; }
-    );
+    return sentences.contains(s);
 }
 
 bool Language::hasAllSentences(const std::vector<Sequence> &sequencesToCheck) const {
@@ -1,26 +1,35 @@
 #ifndef LANGUAGE_H
 #define LANGUAGE_H
 
+#include <cstddef>
 #include <vector>
 #include "Grammar.h"
 
+class CompiledGrammar;
+
 class Language {
 public:
     Language();
     Language(Language&&) noexcept;
 
     static Language languageOf(const Grammar *g, int maxLen);
+    static Language languageOf(const CompiledGrammar &cg, int maxLen); // root has NT index 0
 
     bool hasSentence(const Sequence &s) const;
 
     bool hasAllSentences(const std::vector<Sequence> &sequencesToCheck) const;
 
-    const std::vector<Sequence> &getSequences() const;
+    // unpacked copies of all sentences in lexicographic order
+    std::vector<Sequence> getSequences() const;
+
+    std::size_t size() const; // nr. of sentences
+
+    std::size_t nrOfBytes() const; // memory used for the sentences
 
     ~Language();
 
 private:
-    std::vector<Sequence> sequences;
+    PackedSequenceSet sentences; // compact, sorted lexicographically
 };
 
 #endif
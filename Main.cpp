@@ -5,24 +5,278 @@
 // ====================================================================
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <typeinfo>
+#include <vector>
 
 #include "Language.h"
 #include "SignalHandling.h"
 #include "Timer.h"
+#include "SequenceKernels.h"
 #include "SymbolStuff.h"
 #include "SequenceStuff.h"
 #include "Vocabulary.h"
 #include "GrammarBasics.h"
 #include "GrammarBuilder.h"
 #include "Grammar.h"
+#include "GrammarTransformations.h"
+#include "CompiledGrammar.h"
 
 using namespace std;
 
+
+// *** test case selection: 1, 2, ..., 22 ***
+#define TESTCASE 5
+// *******************************************
+
+#if TESTCASE == 7 || TESTCASE == 9 || TESTCASE == 17 || TESTCASE == 19
+#define COUNT_ALLOCATIONS
+#endif
+
+#ifdef COUNT_ALLOCATIONS // replace all global operators new and delete to count heap allocations
+static atomic<long> nrOfAllocations(0);
+
+#ifdef _MSC_VER // no std::aligned_alloc
+#define ALIGNED_ALLOC(alignment, size) _aligned_malloc(size, alignment)
+#define ALIGNED_FREE(p)                _aligned_free(p)
+#else
+#define ALIGNED_ALLOC(alignment, size) aligned_alloc(alignment, size)
+#define ALIGNED_FREE(p)                free(p)
+#endif
+
+static void *countedAllocation(size_t size) noexcept {
+    nrOfAllocations++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+static void *countedAllocation(size_t size, align_val_t alignment) noexcept {
+    nrOfAllocations++;
+    const size_t al = static_cast<size_t>(alignment);
+    return ALIGNED_ALLOC(al, (size == 0 ? al : (size + al - 1) / al * al)); // multiple of al
+}
+
+static void *checked(void *p) {
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void *operator new  (size_t size) { return checked(countedAllocation(size)); }
+void *operator new[](size_t size) { return checked(countedAllocation(size)); }
+void *operator new  (size_t size, const nothrow_t &) noexcept { return countedAllocation(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return countedAllocation(size); }
+void *operator new  (size_t size, align_val_t al) { return checked(countedAllocation(size, al)); }
+void *operator new[](size_t size, align_val_t al) { return checked(countedAllocation(size, al)); }
+void *operator new  (size_t size, align_val_t al, const nothrow_t &) noexcept { return countedAllocation(size, al); }
+void *operator new[](size_t size, align_val_t al, const nothrow_t &) noexcept { return countedAllocation(size, al); }
+
+// all memory comes from countedAllocation, so free is right: g++ only sees operator new when inlining delete
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete  (void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete  (void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete  (void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete  (void *p, align_val_t) noexcept { ALIGNED_FREE(p); }
+void operator delete[](void *p, align_val_t) noexcept { ALIGNED_FREE(p); }
+void operator delete  (void *p, size_t, align_val_t) noexcept { ALIGNED_FREE(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { ALIGNED_FREE(p); }
+void operator delete  (void *p, align_val_t, const nothrow_t &) noexcept { ALIGNED_FREE(p); }
+void operator delete[](void *p, align_val_t, const nothrow_t &) noexcept { ALIGNED_FREE(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// generates a random grammar text with nrOfNts rules, every nonterminal has a rule,
+//   every epsilonEvery-th one (if > 0) also has an epsilon alternative
+string generatedGrammarText(const int nrOfNts, const int nrOfTs, const unsigned seed, const int epsilonEvery = 0) {
+    mt19937 rng(seed);
+    ostringstream oss;
+    oss << "G(N0):" << endl;
+    for (int nt = 0; nt < nrOfNts; nt++) {
+        oss << "N" << nt << " ->";
+        const int nrOfAlts = 1 + static_cast<int>(rng() % 4);
+        for (int alt = 0; alt < nrOfAlts; alt++) {
+            if (alt > 0)
+                oss << " |";
+            const int len = 1 + static_cast<int>(rng() % 5);
+            for (int i = 0; i < len; i++) {
+                if (rng() % 3 == 0)
+                    oss << " N" << rng() % nrOfNts;
+                else
+                    oss << " t" << rng() % nrOfTs;
+            }
+        }
+        if (epsilonEvery > 0 && nt % epsilonEvery == 0)
+            oss << " | eps";
+        oss << endl;
+    }
+    return oss.str();
+}
+
+#if TESTCASE == 11
+// the former Sequence::operator==, symbol by symbol, not inlined as operator== is not either
+__attribute__((noinline)) bool formerEquals(const Sequence &seq1, const Sequence &seq2) {
+    return seq1.length() == seq2.length() &&
+           equal(seq1.begin(), seq1.end(), seq2.begin(), EqualForSymbolPtrs());
+}
+#endif
+
+#if TESTCASE == 12
+// the former Grammar::deletableNTs: rescans all rules until no more deletable NTs are found
+VNt formerDeletableNTs(const Grammar *g) {
+    VNt vNtDel;
+    for (auto &rule: g->rules)
+        for (const Sequence *seq: rule.second)
+            if (seq->isEpsilon())
+                vNtDel.insert(rule.first);
+    size_t oldSize;
+    do {
+        oldSize = vNtDel.size();
+        for (auto &rule: g->rules)
+            if (!vNtDel.contains(rule.first))
+                for (const Sequence *seq: rule.second)
+                    if (all_of(seq->begin(), seq->end(), [&vNtDel](const Symbol *sy) {
+                            return sy->isNT() && vNtDel.contains(asNT(sy));
+                        })) {
+                        vNtDel.insert(rule.first);
+                        break;
+                    }
+    } while (vNtDel.size() > oldSize);
+    return vNtDel;
+}
+
+// a chain N0 -> N1 | t N0, N1 -> N2 | t N1, ..., only the last NT has an epsilon alternative,
+//   so every rescan of the former algorithm finds only one more deletable NT
+string chainGrammarText(const int nrOfNts) {
+    ostringstream oss;
+    oss << "G(N0):" << endl;
+    for (int nt = 0; nt < nrOfNts - 1; nt++)
+        oss << "N" << nt << " -> N" << nt + 1 << " | t" << nt % 100 << " N" << nt << endl;
+    oss << "N" << nrOfNts - 1 << " -> eps | t0" << endl;
+    return oss.str();
+}
+#endif
+
+#if TESTCASE == 14
+// the former FIRST and FOLLOW sets of Grammar: iteration over all rules until no set grows
+TSetsMap formerFirstSets(const Grammar *g) {
+    const VNt &deletable = g->deletableNTs();
+    TSetsMap first;
+    for (auto &rule: g->rules)
+        first[rule.first];
+    bool changed;
+    do {
+        changed = false;
+        for (auto &rule: g->rules) {
+            VT &firstOfNt = first[rule.first];
+            const size_t oldSize = firstOfNt.size();
+            for (const Sequence *seq: rule.second)
+                for (Symbol *sy: *seq) {
+                    if (sy->isT()) {
+                        firstOfNt.insert(asT(sy));
+                        break;
+                    }
+                    firstOfNt += first[asNT(sy)];
+                    if (!deletable.contains(asNT(sy)))
+                        break;
+                }
+            changed = changed || firstOfNt.size() > oldSize;
+        }
+    } while (changed);
+    return first;
+}
+
+TSetsMap formerFollowSets(const Grammar *g, TSetsMap &first) {
+    const VNt &deletable = g->deletableNTs();
+    TSetsMap follow;
+    for (auto &rule: g->rules)
+        follow[rule.first];
+    bool changed;
+    do {
+        changed = false;
+        for (auto &rule: g->rules)
+            for (const Sequence *seq: rule.second) {
+                VT trailer = follow[rule.first];
+                for (auto it = seq->end(); it != seq->begin();) {
+                    Symbol *sy = *--it;
+                    if (sy->isT()) {
+                        trailer.clear();
+                        trailer.insert(asT(sy));
+                        continue;
+                    }
+                    VT &followOfNt = follow[asNT(sy)];
+                    const size_t oldSize = followOfNt.size();
+                    followOfNt += trailer;
+                    changed = changed || followOfNt.size() > oldSize;
+                    if (deletable.contains(asNT(sy)))
+                        trailer += first[asNT(sy)];
+                    else
+                        trailer = first[asNT(sy)];
+                }
+            }
+    } while (changed);
+    return follow;
+}
+#endif
+
+#if TESTCASE == 16
+// the former order of NTs for operator<<: a linear search for every NT occurrence
+vector<NTSymbol *> formerTopSortedNts(const Grammar *g) {
+    vector<NTSymbol *> ntv;
+    ntv.push_back(g->root);
+    for (size_t i = 0; i < ntv.size(); i++)
+        for (const Sequence *seq: g->rules[ntv[i]])
+            for (Symbol *sy: *seq)
+                if (sy->isNT() && find(ntv.begin(), ntv.end(), asNT(sy)) == ntv.end())
+                    ntv.push_back(asNT(sy));
+    for (auto &rule: g->rules)
+        if (find(ntv.begin(), ntv.end(), rule.first) == ntv.end())
+            ntv.push_back(rule.first);
+    return ntv;
+}
+
+// the former operator<<, writing line by line with endl
+void formerPrint(ostream &os, const Grammar *g, const vector<NTSymbol *> &ntv) {
+    os << endl << "G(" << *g->root << "):" << endl;
+    for (NTSymbol *ntSy: ntv) {
+        os << *ntSy << " -> ";
+        bool first = true;
+        for (const Sequence *seq: g->rules[ntSy]) {
+            if (!first)
+                os << " | ";
+            os << *seq;
+            first = false;
+        }
+        os << endl;
+    }
+    os << "---" << endl << "VNt = " << g->vNt << ", deletable: " << g->deletableNTs() << endl
+       << "VT  = " << g->vT << endl << endl;
+}
+#endif
+
+#if TESTCASE == 17
+// the former epsilon-free transformation: all 2^k variants of an alternative with k
+//   deletable NTs are allocated before duplicates are discarded, the empty one leaks
 bool containsEpsilonOrMarkedNT(const Sequence &seq, const VNt &epsilonNonterminals) {
     return std::any_of(seq.begin(), seq.end(), [&epsilonNonterminals](Symbol *s) {
-        return s->isNT() && epsilonNonterminals.contains(dynamic_cast<NTSymbol *>(s));
+        return s->isNT() && epsilonNonterminals.contains(asNT(s));
     });
 }
 
@@ -40,7 +294,7 @@ vector<Sequence *> generateEpsilonFreeCombinations(const Sequence &seq, const VN
 
     for (Symbol *s: seq) {
         const size_t currentSize = result.size();
-        if (s->isNT() && epsilonNonterminals.contains(dynamic_cast<NTSymbol *>(s))) {
+        if (s->isNT() && epsilonNonterminals.contains(asNT(s))) {
             // For epsilon-producing NTs, include both with and without NT
             for (size_t i = 0; i < currentSize; ++i) {
                 result.push_back(new Sequence(*result[i])); // Copy existing sequences
@@ -75,13 +329,12 @@ void explodeDeletableRules(GrammarBuilder &epsilonFreeBuilder, const Sequence &s
     }
 }
 
-Grammar *newEpsilonFreeGrammar(const Grammar *g) {
+Grammar *formerEpsilonFreeGrammar(const Grammar *g) {
     // Initialize a new grammar builder with the same root
     const auto epsilonFreeBuilder = std::make_unique<GrammarBuilder>(g->root);
 
     // Step 1 Mark all deletable non-terminals
     const VNt epsilonNonterminals = g->deletableNTs();
-    cout << "Deletable non-terminals: " << epsilonNonterminals << endl;
 
     for (const auto &rule: g->rules) {
         auto const &nt = rule.first;
@@ -97,7 +350,6 @@ Grammar *newEpsilonFreeGrammar(const Grammar *g) {
 
     // Step 4: Add S' -> S | ε if S is deletable
     if (epsilonNonterminals.contains(g->root)) {
-        cout << "Root is deletable" << endl;
         SymbolPool sp;
         auto *optS = sp.ntSymbol("S'");
         epsilonFreeBuilder->addRule(optS, new Sequence(g->root));
@@ -105,11 +357,38 @@ Grammar *newEpsilonFreeGrammar(const Grammar *g) {
         epsilonFreeBuilder->setNewRoot(optS);
     }
 
-    Grammar *resultGrammar = epsilonFreeBuilder->buildGrammar();
+    Grammar *resultGrammar = std::move(*epsilonFreeBuilder).buildGrammar(); // builder not used any more
     return resultGrammar;
 }
+#endif
+
+#if TESTCASE == 21
+// a non-seekable stream buffer like the one of a pipe: delivers text in chunks of 4 KB
+class PipeBuffer: public streambuf {
+public:
+    explicit PipeBuffer(const string &text) : text(text) {
+    }
+
+protected:
+    int_type underflow() override {
+        if (pos >= text.size())
+            return traits_type::eof();
+        const size_t len = min<size_t>(4096, text.size() - pos);
+        char *chunkStart = const_cast<char *>(text.data()) + pos;
+        setg(chunkStart, chunkStart, chunkStart + len);
+        pos += len;
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    const string &text;
+    size_t pos = 0;
+};
+#endif
 
 int main(int argc, char *argv[]) {
+    (void)argc; // argc and argv are used by some TESTCASEs only
+    (void)argv;
     installSignalHandlers();
 
     cout << "START Main" << endl;
@@ -129,10 +408,6 @@ int main(int argc, char *argv[]) {
         Grammar *g3 = nullptr;
 
 
-        // *** test case selection: 1, 2, or 3 ***
-#define TESTCASE 5
-        // ***************************************
-
         cout << "TESTCASE " << TESTCASE << endl << endl;
 
 #if TESTCASE == 1 // programmatical grammar construction
@@ -212,6 +487,9 @@ int main(int argc, char *argv[]) {
         cout << "Original Grammar with epsilon rules:" << endl;
         cout << *originalGrammar << endl;
 
+        cout << "Deletable non-terminals: " << originalGrammar->deletableNTs() << endl;
+        if (originalGrammar->deletableNTs().contains(originalGrammar->root))
+            cout << "Root is deletable" << endl;
         const auto *epsilonFreeGrammar = newEpsilonFreeGrammar(originalGrammar);
         cout << endl << "Epsilon-Free Grammar:" << endl;
         cout << *epsilonFreeGrammar << endl;
@@ -268,6 +546,710 @@ int main(int argc, char *argv[]) {
 
         delete g;
 
+#elif TESTCASE == 6 // stress test and benchmark for concurrent symbol interning
+
+        const int nrOfThreads = 8;
+        const int nrOfNames   = 1000000; // distinct names, interned by every thread
+
+        vector<string> names;
+        names.reserve(nrOfNames);
+        for (int i = 0; i < nrOfNames; i++)
+            names.push_back("t" + to_string(i));
+
+        // round 1 creates all symbols concurrently, round 2 only looks them up
+        vector<vector<TSymbol *> > results(nrOfThreads, vector<TSymbol *>(nrOfNames));
+        for (int round = 1; round <= 2; round++) {
+            const auto start = chrono::steady_clock::now();
+            vector<thread> threads;
+            for (int t = 0; t < nrOfThreads; t++) {
+                threads.emplace_back([&names, &results, t]() {
+                    SymbolPool tsp; // one pool per thread, all share the same symbols
+                    for (int k = 0; k < nrOfNames; k++) {
+                        const int i = (k + t * (nrOfNames / nrOfThreads)) % nrOfNames;
+                        results[t][i] = tsp.tSymbol(names[i]);
+                    }
+                });
+            }
+            for (auto &th: threads)
+                th.join();
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            const double nrOfInterns = double(nrOfThreads) * nrOfNames;
+            cout << "round " << round << ": " << nrOfInterns << " interns by "
+                 << nrOfThreads << " threads in " << secs.count() << " s = "
+                 << nrOfInterns / secs.count() / 1e6 << " M interns/s" << endl;
+        }
+
+        if (sp->nrOfSymbols() != static_cast<Symbol::Id>(nrOfNames))
+            throw runtime_error("Error: wrong number of symbols in symbol pool.");
+        vector<bool> idSeen(nrOfNames, false);
+        for (int i = 0; i < nrOfNames; i++) {
+            TSymbol *tSy = results[0][i];
+            if (tSy->name != names[i] || tSy->id >= idSeen.size() || idSeen[tSy->id])
+                throw runtime_error("Error: invalid or duplicate symbol " + names[i] + ".");
+            idSeen[tSy->id] = true;
+            for (int t = 1; t < nrOfThreads; t++)
+                if (results[t][i] != tSy)
+                    throw runtime_error("Error: threads got different symbols for " + names[i] + ".");
+        }
+
+        cout << "All threads got the same symbols with unique dense ids." << endl;
+
+#elif TESTCASE == 7 // heap allocations per token when reading grammars
+
+        const string text = generatedGrammarText(20000, 200, 4711);
+        long nrOfTokens = 0;
+        string_view rest = text;
+        while (!nextToken(rest).empty())
+            nrOfTokens++;
+
+        // pass 1 interns all symbols, pass 2 finds all symbols in the pool,
+        //   so pass 2 shows the costs of the tokenizer and the lookups
+        for (int pass = 1; pass <= 2; pass++) {
+            const long nrOfAllocationsBefore = nrOfAllocations;
+            const auto start = chrono::steady_clock::now();
+            GrammarBuilder gb(text.c_str());
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            const long nrOfAllocationsForGb = nrOfAllocations - nrOfAllocationsBefore;
+            cout << "pass " << pass << ": " << nrOfTokens << " tokens, "
+                 << nrOfAllocationsForGb << " allocations = "
+                 << double(nrOfAllocationsForGb) / nrOfTokens << " allocations/token, "
+                 << secs.count() << " s" << endl;
+        }
+
+#elif TESTCASE == 8 // lookups of bulk input sentences in a frozen symbol pool
+
+        GrammarBuilder gb(generatedGrammarText(20000, 200, 4711).c_str());
+        Grammar *g = gb.buildGrammar();
+
+        // a bulk input of known names and, in a second input, unknown names
+        mt19937 rng(4711);
+        string input, unknownInput;
+        const int nrOfTokens = 1000000;
+        for (int i = 0; i < nrOfTokens; i++) {
+            input += (rng() % 2 == 0) ? "t" + to_string(rng() % 200) + " "
+                                      : "N" + to_string(rng() % 20000) + " ";
+            unknownInput += "u" + to_string(rng() % 20000) + " ";
+        }
+
+        vector<Symbol *> unfrozenSymbols;
+        for (int round = 1; round <= 2; round++) {
+            if (round == 2)
+                sp->freeze();
+            const auto start = chrono::steady_clock::now();
+            Sequence seq(input);
+            int nrOfUnknowns = 0;
+            string_view rest = unknownInput;
+            for (string_view name = nextToken(rest); !name.empty(); name = nextToken(rest))
+                if (sp->symbolFor(name) == nullptr)
+                    nrOfUnknowns++;
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            cout << (sp->isFrozen() ? "frozen:   " : "unfrozen: ") << 2 * nrOfTokens
+                 << " lookups in " << secs.count() << " s = "
+                 << 2 * nrOfTokens / secs.count() / 1e6 << " M lookups/s" << endl;
+            if (seq.length() != nrOfTokens || nrOfUnknowns != nrOfTokens)
+                throw runtime_error("Error: wrong results of lookups.");
+            if (round == 1)
+                unfrozenSymbols.assign(seq.begin(), seq.end());
+            else if (!equal(seq.begin(), seq.end(), unfrozenSymbols.begin(), unfrozenSymbols.end()))
+                throw runtime_error("Error: frozen pool delivered different symbols.");
+        }
+
+        // interning new names thaws the pool
+        NTSymbol *ntSy = sp->ntSymbol("NewNT");
+        if (sp->isFrozen() || sp->symbolFor("NewNT") != ntSy || sp->symbolFor("t42") == nullptr)
+            throw runtime_error("Error: thawing the symbol pool failed.");
+        sp->freeze();
+        if (!sp->isFrozen() || sp->symbolFor("NewNT") != ntSy)
+            throw runtime_error("Error: freezing the symbol pool again failed.");
+        sp->thaw();
+
+        cout << "Frozen and unfrozen symbol pools deliver the same symbols." << endl;
+
+        delete g;
+
+#elif TESTCASE == 9 // heap allocations of languageOf
+
+        const GrammarBuilder gb(
+            "G(S):                      \n\
+    S -> a B | b A                 \n\
+    A -> a | a S | b A A           \n\
+    B -> b | b S | a B B            ");
+        const Grammar *g = gb.buildGrammar();
+
+        for (int maxLength = 6; maxLength <= 14; maxLength += 2) {
+            const long nrOfAllocationsBefore = nrOfAllocations;
+            const auto start = chrono::steady_clock::now();
+            const auto language = Language::languageOf(g, maxLength);
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            const long nrOfAllocationsForLanguage = nrOfAllocations - nrOfAllocationsBefore;
+            size_t nrOfBytesUnpacked = 0; // for the sentences as vector<Sequence>
+            for (const Sequence &seq: language.getSequences())
+                nrOfBytesUnpacked += sizeof(Sequence) +
+                    (seq.size() > Sequence::inlineCapacity ? seq.size() * sizeof(Symbol *) : 0);
+            cout << "maxLength " << maxLength << ": "
+                 << language.size() << " sentences, "
+                 << nrOfAllocationsForLanguage << " allocations, "
+                 << secs.count() << " s, bytes/sentence: "
+                 << double(language.nrOfBytes()) / language.size() << " packed, "
+                 << double(nrOfBytesUnpacked) / language.size() << " unpacked" << endl;
+        }
+
+        delete g;
+
+#elif TESTCASE == 10 // iteration over rules: deletableNTs and operator<<
+
+        const Grammar *g = GrammarBuilder(generatedGrammarText(2000, 200, 4711).c_str()).buildGrammar();
+
+        const int nrOfRepetitions = 1000;
+        auto start = chrono::steady_clock::now();
+        size_t nrOfDeletables = 0;
+        for (int i = 0; i < nrOfRepetitions; i++)
+            nrOfDeletables += g->deletableNTs().size();
+        chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        cout << nrOfRepetitions << " x deletableNTs: " << secs.count() << " s ("
+             << nrOfDeletables / nrOfRepetitions << " deletable)" << endl;
+
+        start = chrono::steady_clock::now();
+        size_t nrOfChars = 0;
+        for (int i = 0; i < nrOfRepetitions / 10; i++) {
+            ostringstream oss;
+            oss << *g;
+            nrOfChars += oss.str().length();
+        }
+        secs = chrono::steady_clock::now() - start;
+        cout << nrOfRepetitions / 10 << " x operator<<: " << secs.count() << " s ("
+             << nrOfChars / (nrOfRepetitions / 10) << " chars)" << endl;
+
+        delete g;
+
+#elif TESTCASE == 11 // micro-benchmark of the kernels for comparing and hashing sequences
+
+        vector<Symbol *> symbols;
+        for (int i = 0; i < 300; i++)
+            symbols.push_back(sp->tSymbol("t" + to_string(i)));
+
+        const int nrOfPairs = 1000;
+        const long nrOfSymbolsPerLength = 50000000; // same work for all lengths
+        mt19937 rng(4711);
+        cout << "best kernels: " << sequenceKernels().name << endl;
+        cout << "ns per operation (mismatch / crc32c) for pairs of sequences that differ in the last symbol" << endl;
+        for (int len = 1; len <= 64; len *= 2) {
+            vector<Sequence> seqs1, seqs2;
+            vector<unique_ptr<PackedIds> > ids1, ids2;
+            for (int p = 0; p < nrOfPairs; p++) {
+                Sequence seq1, seq2;
+                for (int i = 0; i < len; i++) {
+                    const size_t k = rng() % symbols.size();
+                    seq1.push_back(symbols[k]);
+                    seq2.push_back(i < len - 1 ? symbols[k] : symbols[(k + 1) % symbols.size()]);
+                }
+                ids1.push_back(make_unique<PackedIds>(seq1, 1));
+                ids2.push_back(make_unique<PackedIds>(seq2, 1));
+                seqs1.push_back(std::move(seq1));
+                seqs2.push_back(std::move(seq2));
+            }
+            const long nrOfRuns = max(1L, nrOfSymbolsPerLength / (long(len) * nrOfPairs));
+            const double nrOfOps = double(nrOfRuns) * nrOfPairs;
+            const size_t nrOfBytes = len * sizeof(uint16_t);
+
+            cout << "len " << len << ":";
+            size_t inlineMismatches = 0; // loop over the words as used below minLengthForMismatchKernel
+            auto inlineStart = chrono::steady_clock::now();
+            for (long r = 0; r < nrOfRuns; r++)
+                for (int p = 0; p < nrOfPairs; p++) {
+                    const uint16_t *w1 = ids1[p]->view().data(), *w2 = ids2[p]->view().data();
+                    size_t i = 0;
+                    while (i < size_t(len) && w1[i] == w2[i])
+                        i++;
+                    inlineMismatches += i * sizeof(uint16_t);
+                }
+            const chrono::duration<double> inlineSecs = chrono::steady_clock::now() - inlineStart;
+            cout << " inline " << inlineSecs.count() / nrOfOps * 1e9 << ",";
+            size_t scalarMismatches = 0;
+            uint32_t scalarCrcs = 0;
+            for (KernelIsa isa: {KernelIsa::scalar, KernelIsa::sse42, KernelIsa::avx2}) {
+                const SequenceKernels *k = sequenceKernelsFor(isa);
+                if (k == nullptr)
+                    continue;
+                size_t mismatches = 0;
+                auto start = chrono::steady_clock::now();
+                for (long r = 0; r < nrOfRuns; r++)
+                    for (int p = 0; p < nrOfPairs; p++)
+                        mismatches += k->mismatch(ids1[p]->view().data(), ids2[p]->view().data(), nrOfBytes);
+                const chrono::duration<double> mismatchSecs = chrono::steady_clock::now() - start;
+                uint32_t crcs = 0;
+                start = chrono::steady_clock::now();
+                for (long r = 0; r < nrOfRuns; r++)
+                    for (int p = 0; p < nrOfPairs; p++)
+                        crcs ^= k->crc32c(crcs, ids1[p]->view().data(), nrOfBytes);
+                const chrono::duration<double> crcSecs = chrono::steady_clock::now() - start;
+                if (isa == KernelIsa::scalar) {
+                    if (mismatches != inlineMismatches)
+                        throw runtime_error("Error: results of scalar kernels differ from inline loop.");
+                    scalarMismatches = mismatches;
+                    scalarCrcs = crcs;
+                } else if (mismatches != scalarMismatches || crcs != scalarCrcs)
+                    throw runtime_error(string("Error: results of ") + k->name + " kernels differ from scalar ones.");
+                cout << " " << k->name << " " << mismatchSecs.count() / nrOfOps * 1e9
+                     << " / " << crcSecs.count() / nrOfOps * 1e9 << ",";
+            }
+
+            // Sequence::operator== with the best kernels vs. the former comparison symbol by symbol
+            int nrOfEquals = 0;
+            auto start = chrono::steady_clock::now();
+            for (long r = 0; r < nrOfRuns; r++)
+                for (int p = 0; p < nrOfPairs; p++)
+                    nrOfEquals += formerEquals(seqs1[p], seqs2[p]);
+            const chrono::duration<double> formerSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            for (long r = 0; r < nrOfRuns; r++)
+                for (int p = 0; p < nrOfPairs; p++)
+                    nrOfEquals += seqs1[p] == seqs2[p];
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            if (nrOfEquals != 0)
+                throw runtime_error("Error: different sequences compared equal.");
+            cout << " Sequence == " << formerSecs.count() / nrOfOps * 1e9 << " former / "
+                 << secs.count() / nrOfOps * 1e9 << " now" << endl;
+        }
+
+#elif TESTCASE == 12 // scaling of deletableNTs on synthetic grammars
+
+        for (int nrOfNts = 2500; nrOfNts <= 20000; nrOfNts *= 2) {
+            for (const bool chain: {true, false}) {
+                const Grammar *g = GrammarBuilder((chain ? chainGrammarText(nrOfNts)
+                                                         : generatedGrammarText(nrOfNts, 200, 4711, 10)).c_str()).buildGrammar();
+                auto start = chrono::steady_clock::now();
+                const VNt vNtDel = g->deletableNTs();
+                const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+                start = chrono::steady_clock::now();
+                const VNt formerVNtDel = formerDeletableNTs(g);
+                const chrono::duration<double> formerSecs = chrono::steady_clock::now() - start;
+                if (!(vNtDel == formerVNtDel))
+                    throw runtime_error("Error: deletableNTs differs from former algorithm.");
+                cout << (chain ? "chain     " : "generated ") << nrOfNts << " NTs, "
+                     << vNtDel.size() << " deletable: " << formerSecs.count() << " s former, "
+                     << secs.count() << " s worklist" << endl;
+                delete g;
+            }
+        }
+
+#elif TESTCASE == 13 // cached analyses of grammars, shared by copies
+
+        const Grammar *g = GrammarBuilder(
+            "G(S):                          \n\
+             S -> E ;                       \n\
+             E -> a A b E | b B a E | eps   \n\
+             A -> a A b A | eps             \n\
+             B -> b B a B | C               \n\
+             C -> c C                       \n\
+             D -> d                         ").buildGrammar();
+        cout << *g;
+        cout << "reachable:  " << g->reachableNTs() << endl;
+        cout << "productive: " << g->productiveNTs() << endl;
+        for (auto &nt: g->vNt)
+            cout << "FIRST(" << *nt << ") = " << g->firstSets().find(nt)->second
+                 << ", FOLLOW(" << *nt << ") = " << g->followSets().find(nt)->second << endl;
+        cout << endl;
+        delete g;
+
+        // first and repeated queries on a large grammar and on a copy of it
+        g = GrammarBuilder(generatedGrammarText(20000, 200, 4711, 10).c_str()).buildGrammar();
+        for (int query = 1; query <= 3; query++) {
+            const Grammar *queried = (query < 3) ? g : new Grammar(*g);
+            const auto start = chrono::steady_clock::now();
+            const size_t nrOfElements = queried->deletableNTs().size() + queried->reachableNTs().size() +
+                                        queried->productiveNTs().size() + queried->firstSets().size() +
+                                        queried->followSets().size() + queried->isEpsilonFree();
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            cout << (query == 1 ? "first queries:    " : query == 2 ? "repeated queries: " : "queries on copy:  ")
+                 << secs.count() << " s (" << nrOfElements << " elements)" << endl;
+            if (queried != g)
+                delete queried;
+        }
+        delete g;
+
+#elif TESTCASE == 14 // FIRST and FOLLOW sets: bitsets over strongly connected components vs. fixpoints
+
+        for (int nrOfNts = 500; nrOfNts <= 8000; nrOfNts *= 2) {
+            const Grammar *g = GrammarBuilder(generatedGrammarText(nrOfNts, 200, 4711, 10).c_str()).buildGrammar();
+            g->deletableNTs(); // computed and cached before
+            auto start = chrono::steady_clock::now();
+            const VT firstOfRoot = g->first(Sequence(g->root)); // computes the bitsets only
+            const chrono::duration<double> bitsetSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            const TSetsMap &first = g->firstSets();
+            const TSetsMap &follow = g->followSets();
+            const chrono::duration<double> mapSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            TSetsMap formerFirst = formerFirstSets(g);
+            TSetsMap formerFollow = formerFollowSets(g, formerFirst);
+            const chrono::duration<double> formerSecs = chrono::steady_clock::now() - start;
+            for (auto &rule: g->rules)
+                if (!(first.find(rule.first)->second == formerFirst[rule.first]) ||
+                    !(follow.find(rule.first)->second == formerFollow[rule.first]) ||
+                    !(g->first(Sequence(rule.first)) == formerFirst[rule.first]))
+                    throw runtime_error("Error: FIRST or FOLLOW sets differ from former ones.");
+            size_t nrOfAlternatives = 0;
+            for (auto &rule: g->rules)
+                nrOfAlternatives += rule.second.size();
+            cout << nrOfNts << " NTs, " << nrOfAlternatives << " alternatives: " << formerSecs.count() << " s former, "
+                 << bitsetSecs.count() << " s bitsets + " << mapSecs.count() << " s for TSetsMaps" << endl;
+            delete g;
+        }
+
+#elif TESTCASE == 15 // reduction of grammars: removal of unproductive and unreachable NTs
+
+        const Grammar *g = GrammarBuilder(
+            "G(S):                          \n\
+             S -> a B | b A | c D           \n\
+             A -> a | a S | b A A | d D     \n\
+             B -> b | b S | a B B           \n\
+             D -> a D | b D D               \n\
+             E -> e S | e                   ").buildGrammar();
+        ReductionReport report;
+        const Grammar *rg = newReducedGrammar(g, &report);
+        cout << *g << report << *rg;
+
+        constexpr int maxLength = 12;
+        auto start = chrono::steady_clock::now();
+        const Language language = Language::languageOf(g, maxLength);
+        const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        start = chrono::steady_clock::now();
+        const Language reducedLanguage = Language::languageOf(rg, maxLength);
+        const chrono::duration<double> reducedSecs = chrono::steady_clock::now() - start;
+        const auto &sentences = language.getSequences();
+        if (sentences.size() != reducedLanguage.getSequences().size() ||
+            !std::all_of(sentences.begin(), sentences.end(),
+                         [&reducedLanguage](const Sequence &s) { return reducedLanguage.hasSentence(s); }))
+            throw runtime_error("Error: languages of original and reduced grammar differ.");
+        cout << sentences.size() << " sentences up to length " << maxLength << ": "
+             << secs.count() << " s original, " << reducedSecs.count() << " s reduced grammar" << endl;
+        delete rg;
+        delete g;
+
+        // reduction of a large generated grammar with a new root reaching all NTs
+        constexpr int nrOfNts = 20000;
+        ostringstream text;
+        text << "G(R):" << endl << "R -> N0";
+        for (int nt = 1; nt < nrOfNts; nt++)
+            text << " | N" << nt;
+        text << endl << generatedGrammarText(nrOfNts, 200, 4711, 10).substr(sizeof("G(N0):"));
+        g = GrammarBuilder(text.str().c_str()).buildGrammar();
+        start = chrono::steady_clock::now();
+        rg = newReducedGrammar(g, &report);
+        const chrono::duration<double> reductionSecs = chrono::steady_clock::now() - start;
+        cout << "generated " << g->vNt.size() << " NTs: " << report.unproductiveNTs.size() << " unproductive, "
+             << report.unreachableNTs.size() << " unreachable, " << report.nrOfRemovedAlternatives
+             << " alternatives removed in " << reductionSecs.count() << " s" << endl;
+        delete rg;
+        delete g;
+
+#elif TESTCASE == 16 // topological order of NTs and buffered operator<< for large grammars
+
+        const char *fileName = "TESTCASE16.txt";
+        for (int nrOfNts = 5000; nrOfNts <= 40000; nrOfNts *= 2) {
+            // a new root reaching all NTs in reverse order
+            ostringstream text;
+            text << "G(R):" << endl << "R -> N" << nrOfNts - 1;
+            for (int nt = nrOfNts - 2; nt >= 0; nt--)
+                text << " | N" << nt;
+            text << endl << generatedGrammarText(nrOfNts, 200, 4711).substr(sizeof("G(N0):"));
+            const Grammar *g = GrammarBuilder(text.str().c_str()).buildGrammar();
+            g->deletableNTs(); // computed and cached before
+
+            auto start = chrono::steady_clock::now();
+            const vector<NTSymbol *> formerNtv = formerTopSortedNts(g);
+            const chrono::duration<double> formerSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            const vector<NTSymbol *> &ntv = g->topologicalNts();
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            if (ntv != formerNtv)
+                throw runtime_error("Error: topological order differs from former one.");
+
+            ofstream ofs(fileName);
+            start = chrono::steady_clock::now();
+            formerPrint(ofs, g, ntv);
+            const chrono::duration<double> formerPrintSecs = chrono::steady_clock::now() - start;
+            ofs.seekp(0);
+            start = chrono::steady_clock::now();
+            ofs << *g;
+            const chrono::duration<double> printSecs = chrono::steady_clock::now() - start;
+            ofs.close();
+            cout << nrOfNts << " NTs, order: " << formerSecs.count() << " s former, " << secs.count()
+                 << " s BFS; operator<< to file: " << formerPrintSecs.count() << " s former, "
+                 << printSecs.count() << " s buffered" << endl;
+            delete g;
+        }
+        remove(fileName);
+
+#elif TESTCASE == 17 // epsilon-free grammars for alternatives with many deletable NTs
+
+        for (int k = 4; k <= 256; k *= 2) {
+            // S -> A1 A2 ... Ak b with Ai -> ai | eps
+            ostringstream text;
+            text << "G(S):" << endl << "S ->";
+            for (int i = 1; i <= k; i++)
+                text << " A" << i;
+            text << " b" << endl;
+            for (int i = 1; i <= k; i++)
+                text << "A" << i << " -> a" << i << " | eps" << endl;
+            const Grammar *g = GrammarBuilder(text.str().c_str()).buildGrammar();
+            g->deletableNTs(); // computed and cached before
+
+            long nrOfAllocationsBefore = nrOfAllocations;
+            auto start = chrono::steady_clock::now();
+            const Grammar *efg = newEpsilonFreeGrammar(g);
+            const chrono::duration<double> secs = chrono::steady_clock::now() - start;
+            const long nrOfAllocationsForEfg = nrOfAllocations - nrOfAllocationsBefore;
+            if (!efg->isEpsilonFree())
+                throw runtime_error("Error: grammar is not epsilon free.");
+            size_t nrOfAlternatives = 0;
+            for (auto &rule: efg->rules)
+                nrOfAlternatives += rule.second.size();
+            cout << "k = " << k << ": " << nrOfAlternatives << " alternatives, " << nrOfAllocationsForEfg
+                 << " allocations, " << secs.count() << " s";
+
+            if (k <= 16) { // 2^k variants
+                nrOfAllocationsBefore = nrOfAllocations;
+                start = chrono::steady_clock::now();
+                const Grammar *formerEfg = formerEpsilonFreeGrammar(g);
+                const chrono::duration<double> formerSecs = chrono::steady_clock::now() - start;
+                const long nrOfAllocationsForFormerEfg = nrOfAllocations - nrOfAllocationsBefore;
+                size_t nrOfFormerAlternatives = 0;
+                for (auto &rule: formerEfg->rules)
+                    nrOfFormerAlternatives += rule.second.size();
+                cout << "; former: " << nrOfFormerAlternatives << " alternatives, " << nrOfAllocationsForFormerEfg
+                     << " allocations, " << formerSecs.count() << " s";
+                const int maxLength = 4;
+                const vector<Sequence> sentences = Language::languageOf(g, maxLength).getSequences();
+                if (sentences != Language::languageOf(efg, maxLength).getSequences() ||
+                    sentences != Language::languageOf(formerEfg, maxLength).getSequences())
+                    throw runtime_error("Error: languages of epsilon-free grammars differ.");
+                delete formerEfg;
+            }
+            cout << endl;
+            delete efg;
+            delete g;
+        }
+
+        // NTs deriving epsilon only via other NTs lose all their rules, so also their occurrences
+        for (const char *text: {"G(S):\nS -> a A\nA -> B\nB -> eps\n",
+                                "G(S):\nS -> A\nA -> eps\n"}) {
+            const Grammar *g = GrammarBuilder(text).buildGrammar();
+            const Grammar *efg = newEpsilonFreeGrammar(g);
+            cout << *efg;
+            if (!efg->isEpsilonFree() ||
+                Language::languageOf(g, 4).getSequences() != Language::languageOf(efg, 4).getSequences())
+                throw runtime_error("Error: epsilon-free grammar is not equivalent.");
+            delete efg;
+            delete g;
+        }
+
+        // names for new NTs must not be used in the grammar, even if another grammar has used them for terminals
+        {
+            const Grammar *g = GrammarBuilder("G(S):\nS -> S' b | eps\nS' -> a\n").buildGrammar();
+            sp->tSymbol("S'");
+            const Grammar *efg = newEpsilonFreeGrammar(g);
+            cout << *efg;
+            if (Language::languageOf(g, 4).getSequences() != Language::languageOf(efg, 4).getSequences())
+                throw runtime_error("Error: epsilon-free grammar is not equivalent.");
+            delete efg;
+            delete g;
+        }
+
+        const Grammar *g = GrammarBuilder("G(S):\nS -> a\n").buildGrammar();
+        try {
+            delete newEpsilonFreeGrammar(g, maxMaxDeletablesPerAlternative + 1);
+        } catch (const exception &e) {
+            cout << "expected exception: " << e.what() << endl;
+        }
+        delete g;
+
+#elif TESTCASE == 18 // compiled grammars (CSR layout) vs. rules maps
+
+        for (int nrOfNts = 5000; nrOfNts <= 40000; nrOfNts *= 2) {
+            const Grammar *g = GrammarBuilder(generatedGrammarText(nrOfNts, 200, 4711, 10).c_str()).buildGrammar();
+            auto start = chrono::steady_clock::now();
+            const CompiledGrammar &cg = g->compiled();
+            const chrono::duration<double> compileSecs = chrono::steady_clock::now() - start;
+
+            // a traversal of all symbols of all rules, 100 times
+            constexpr int nrOfRepetitions = 100;
+            start = chrono::steady_clock::now();
+            size_t mapSum = 0;
+            for (int i = 0; i < nrOfRepetitions; i++)
+                for (auto &rule: g->rules)
+                    for (const Sequence *seq: rule.second)
+                        for (const Symbol *sy: *seq)
+                            mapSum += sy->isNT();
+            const chrono::duration<double> mapSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            size_t csrSum = 0;
+            for (int i = 0; i < nrOfRepetitions; i++)
+                for (uint32_t nt = 0; nt < cg.nrOfNts(); nt++)
+                    for (uint32_t a = cg.firstAlt(nt); a < cg.endAlt(nt); a++)
+                        for (const CompiledGrammar::Tagged *sy = cg.begin(a); sy != cg.end(a); sy++)
+                            csrSum += CompiledGrammar::isNT(*sy);
+            const chrono::duration<double> csrSecs = chrono::steady_clock::now() - start;
+            if (mapSum != csrSum)
+                throw runtime_error("Error: traversals of rules differ.");
+
+            // deletable NTs, uncached on both representations
+            start = chrono::steady_clock::now();
+            const VNt &vNtDel = g->deletableNTs();
+            const chrono::duration<double> rulesDelSecs = chrono::steady_clock::now() - start;
+            start = chrono::steady_clock::now();
+            const vector<bool> deletable = cg.deletableNts();
+            const chrono::duration<double> csrDelSecs = chrono::steady_clock::now() - start;
+            VNt csrVNtDel;
+            for (uint32_t nt = 0; nt < cg.nrOfNts(); nt++)
+                if (deletable[nt])
+                    csrVNtDel.insert(cg.nt(nt));
+            if (!(csrVNtDel == vNtDel))
+                throw runtime_error("Error: deletable NTs differ.");
+
+            cout << nrOfNts << " NTs, " << cg.nrOfAlternatives() << " alternatives: compile " << compileSecs.count()
+                 << " s; " << nrOfRepetitions << " x traversal: " << mapSecs.count() << " s map, "
+                 << csrSecs.count() << " s CSR; deletable: " << rulesDelSecs.count() << " s map, " << csrDelSecs.count() << " s CSR" << endl;
+            delete g;
+        }
+
+#elif TESTCASE == 19 // building grammars: copying vs. consuming builders
+
+        for (int nrOfNts = 10000; nrOfNts <= 80000; nrOfNts *= 2) {
+            const string text = generatedGrammarText(nrOfNts, 200, 4711, 10);
+            GrammarBuilder gb1(text.c_str()), gb2(text.c_str());
+            long nrOfAllocationsBefore = nrOfAllocations;
+            auto start = chrono::steady_clock::now();
+            const Grammar *g1 = gb1.buildGrammar(); // copies all sequences
+            const chrono::duration<double> copySecs = chrono::steady_clock::now() - start;
+            const long nrOfAllocationsForCopy = nrOfAllocations - nrOfAllocationsBefore;
+            nrOfAllocationsBefore = nrOfAllocations;
+            start = chrono::steady_clock::now();
+            const Grammar *g2 = std::move(gb2).buildGrammar(); // takes over all sequences
+            const chrono::duration<double> moveSecs = chrono::steady_clock::now() - start;
+            const long nrOfAllocationsForMove = nrOfAllocations - nrOfAllocationsBefore;
+            cout << nrOfNts << " NTs: buildGrammar() " << copySecs.count() << " s, " << nrOfAllocationsForCopy
+                 << " allocations; std::move(gb).buildGrammar() " << moveSecs.count() << " s, "
+                 << nrOfAllocationsForMove << " allocations" << endl;
+            delete g1;
+            delete g2;
+        }
+
+#elif TESTCASE == 20 // copies of grammars for worker threads
+
+        const Grammar *g = GrammarBuilder(generatedGrammarText(40000, 200, 4711, 10).c_str()).buildGrammar();
+        g->deletableNTs(); // computed and cached before
+
+        constexpr int nrOfCopies = 100;
+        auto start = chrono::steady_clock::now();
+        vector<unique_ptr<const Grammar> > copies;
+        for (int i = 0; i < nrOfCopies; i++)
+            copies.push_back(make_unique<const Grammar>(*g));
+        const chrono::duration<double> copySecs = chrono::steady_clock::now() - start;
+
+        // each worker queries and destroys its copy, the last one destroys the shared data
+        start = chrono::steady_clock::now();
+        atomic<size_t> nrOfDeletables(0);
+        vector<thread> workers;
+        for (auto &copy: copies)
+            workers.emplace_back([&nrOfDeletables](unique_ptr<const Grammar> grammar) {
+                nrOfDeletables += grammar->deletableNTs().size();
+            }, std::move(copy));
+        delete g;
+        for (thread &worker: workers)
+            worker.join();
+        const chrono::duration<double> workerSecs = chrono::steady_clock::now() - start;
+        cout << nrOfCopies << " copies of a grammar with 40000 NTs: " << copySecs.count() << " s, "
+             << nrOfCopies << " workers: " << workerSecs.count() << " s ("
+             << nrOfDeletables / nrOfCopies << " deletable NTs each)" << endl;
+
+#elif TESTCASE == 21 // single-pass reading of grammars from files and pipes
+
+        // NTs are classified per grammar, even if another grammar has used their names for terminals
+        delete GrammarBuilder("G(X):\nX -> A R\n").buildGrammar();
+        for (const string text: {"G(S):\nS -> A b\nA -> y\n", "G(R):\nR -> y\n"}) {
+            PipeBuffer pipeBuffer(text);
+            istream pipe(&pipeBuffer);
+            const Grammar *textG = GrammarBuilder(text.c_str()).buildGrammar();
+            const Grammar *pipeG = GrammarBuilder(pipe).buildGrammar();
+            cout << *textG;
+            const size_t nrOfRules = count(text.begin(), text.end(), '\n') - 1;
+            if (textG->vNt.size() != nrOfRules || pipeG->vNt.size() != nrOfRules)
+                throw runtime_error("Error: left-hand sides not classified as NTs.");
+            delete textG;
+            delete pipeG;
+        }
+
+        const char *fileName = "TESTCASE21.txt";
+        for (int nrOfNts = 20000; nrOfNts <= 160000; nrOfNts *= 2) {
+            const string text = generatedGrammarText(nrOfNts, 200, 4711, 10);
+            ofstream(fileName) << text;
+            const double nrOfMBs = text.size() / 1e6;
+
+            auto start = chrono::steady_clock::now();
+            GrammarBuilder fileGb((string(fileName)));
+            const chrono::duration<double> fileSecs = chrono::steady_clock::now() - start;
+
+            PipeBuffer pipeBuffer(text);
+            istream pipe(&pipeBuffer);
+            if (pipe.seekg(0).good())
+                throw runtime_error("Error: pipe must not be seekable.");
+            pipe.clear();
+            start = chrono::steady_clock::now();
+            GrammarBuilder pipeGb(pipe);
+            const chrono::duration<double> pipeSecs = chrono::steady_clock::now() - start;
+
+            const Grammar *fileG = std::move(fileGb).buildGrammar();
+            const Grammar *pipeG = std::move(pipeGb).buildGrammar();
+            ostringstream fileOs, pipeOs; // root, all alternatives and vocabularies
+            fileOs << *fileG;
+            pipeOs << *pipeG;
+            if (fileOs.str() != pipeOs.str())
+                throw runtime_error("Error: grammars from file and pipe differ.");
+            cout << nrOfMBs << " MB (" << nrOfNts << " NTs): file " << nrOfMBs / fileSecs.count()
+                 << " MB/s, pipe " << nrOfMBs / pipeSecs.count() << " MB/s" << endl;
+            delete fileG;
+            delete pipeG;
+        }
+        remove(fileName);
+
+#elif TESTCASE == 22 // loading of large grammar files: memory-mapped vs. streamed in chunks
+
+        // errors are reported with line and column
+        for (const char *text: {"G(S):\n  S -> a | b\n  // comment\n  A => a\n",
+                                "G(S):\n  S -> a A\n  A -> a\n  S -> b\n---\nignored"}) {
+            try {
+                GrammarBuilder gb(text);
+            } catch (const exception &e) {
+                cout << "error: " << e.what() << endl;
+            }
+        }
+
+        // the grammar file given as first argument, e.g., for loading it after
+        //   dropping the page cache, or a generated one with about 50 MB
+        const bool generated = argc < 2;
+        const char *fileName = generated ? "TESTCASE22.txt" : argv[1];
+        if (generated) {
+            const int nrOfNts = 1000000;
+            const string text = generatedGrammarText(nrOfNts, 200, 4711, 10);
+            ofstream(fileName) << text << "---" << endl << "// trailer is ignored" << endl;
+            cout << "file with " << nrOfNts << " NTs: " << text.size() / 1e6 << " MB" << endl;
+        }
+        for (int run = 1; run <= 2; run++) {
+            auto start = chrono::steady_clock::now();
+            GrammarBuilder mappedGb((string(fileName)));
+            const chrono::duration<double> mappedSecs = chrono::steady_clock::now() - start;
+            ifstream ifs(fileName);
+            start = chrono::steady_clock::now();
+            GrammarBuilder streamedGb(ifs); // read and scanned chunk by chunk
+            const chrono::duration<double> streamedSecs = chrono::steady_clock::now() - start;
+            cout << (run == 1 ? "first load:  " : "second load: ") << mappedSecs.count() << " s memory-mapped, "
+                 << streamedSecs.count() << " s streamed in chunks" << endl;
+        }
+        if (generated)
+            remove(fileName);
+
 #else // none of the TESTCASEs above
 
   cerr << "ERROR: invalid TESTCASE " << TESTCASE << endl;
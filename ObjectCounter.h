@@ -31,14 +31,20 @@
 // Additionally, the idiom construct on first use is applied to guarantee
 // a correct initialization order of global objects,
 // see: en.wikibooks.org/wiki/More_C%2B%2B_Idioms/Construct_On_First_Use
+//
+// Counting is thread safe: the counters are atomics and only the object
+// map of a class (LOG_OBJECTS) is guarded, by a mutex of its own, so
+// threads counting objects of different classes do not block each other.
 // =====================================================================
 
 #ifndef ObjectCounter_h
 #define ObjectCounter_h
 
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <fstream>
 #include <string>
 #include <stdexcept>
@@ -124,17 +130,32 @@ class OCData final { // data for the ObjectCounters: one OCData object per class
       return *p;
     } // ocdm
 
+    static std::mutex &ocdMutex() { // guards ocdm (and the log file)
+      static std::mutex m;
+      return m;
+    } // ocdMutex
+
     const std::string className;     // format depends on RTTI, roughly "...UDC..."
     const std::string baseClassName; // format depends on RTTI, roughly "...BASE..."
     const std::string demangledClassName;
     const bool hasBaseClass;         // true <==> className =! baseClassName
-    int nConstr, nDestr;             // number of constructions and destructions
+    std::atomic<OCData *> baseOcd;   // OCData of base class, set on first use
+    std::atomic<int> nConstr, nDestr; // number of constructions and destructions
 #ifdef LOG_OBJECTS
+    std::mutex omMutex;                 // guards om only
     std::unordered_map<void *, int> om; // object map: address -> nConstr
-  #ifdef LOG_OBJECTS_TO_FILE
-  #endif
 #endif
 
+    OCData &baseOCData() { // looked up in ocdm once
+      OCData *b = baseOcd.load(std::memory_order_acquire);
+      if (b == nullptr) {
+        std::lock_guard<std::mutex> lock(ocdMutex());
+        b = ocdm()[baseClassName];
+        baseOcd.store(b, std::memory_order_release);
+      } // if
+      return *b;
+    } // baseOCData
+
   public:
 
     OCData(                  ) = delete;
@@ -147,11 +168,12 @@ class OCData final { // data for the ObjectCounters: one OCData object per class
       baseClassName(baseClassName),
       demangledClassName(demangled(className)),
       hasBaseClass(className != baseClassName),
-      nConstr(0), nDestr(0)
+      baseOcd(nullptr), nConstr(0), nDestr(0)
 #ifdef LOG_OBJECTS
-      , om()
+      , omMutex(), om()
 #endif
     {
+      std::lock_guard<std::mutex> lock(ocdMutex());
       ocdm()[className] = this; // register OCData for className
     } // OCData
 
@@ -160,18 +182,22 @@ class OCData final { // data for the ObjectCounters: one OCData object per class
 
     void countConstr(void *otc) { // object to count
       if (hasBaseClass)
-        ocdm()[baseClassName]->nConstr--;
-      nConstr++;
+        baseOCData().nConstr--;
+      [[maybe_unused]] const int nr = ++nConstr; // of this construction
 #ifdef LOG_OBJECTS
   #ifdef LOG_OBJECTS_TO_FILE
-      oclog() << demangledClassName << "; \t+" << nConstr << "; \t" << otc << std::endl;
+      {
+        std::lock_guard<std::mutex> lock(ocdMutex());
+        oclog() << demangledClassName << "; \t+" << nr << "; \t" << otc << std::endl;
+      }
   #endif
   #ifdef EXCEPT_ON_CONSTR_OF_GARBAGE
       if (demangledClassName == DEMANGLED_CLASS_NAME &&
-          nConstr            == CONSTR_NUMBER)
+          nr                 == CONSTR_NUMBER)
         throw_runtime_error("construction of garbage object", demangledClassName);
   #endif
-      auto ir = om.insert(std::make_pair(otc, nConstr));
+      std::lock_guard<std::mutex> lock(omMutex);
+      auto ir = om.insert(std::make_pair(otc, nr));
       if (!ir.second)       // otc already has been an element of om
         throw_runtime_error("re-construction of object", demangledClassName);
 #endif
@@ -179,12 +205,16 @@ class OCData final { // data for the ObjectCounters: one OCData object per class
 
     void countDestr(void *otc) {
       if (hasBaseClass)
-        ocdm()[baseClassName]->nDestr--;
-      nDestr++;
+        baseOCData().nDestr--;
+      [[maybe_unused]] const int nr = ++nDestr; // of this destruction
 #ifdef LOG_OBJECTS
   #ifdef LOG_OBJECTS_TO_FILE
-      oclog() << demangledClassName << "; \t-" << nDestr << "; \t" << otc << std::endl;
+      {
+        std::lock_guard<std::mutex> lock(ocdMutex());
+        oclog() << demangledClassName << "; \t-" << nr << "; \t" << otc << std::endl;
+      }
   #endif
+      std::lock_guard<std::mutex> lock(omMutex);
       auto ec = om.erase(otc);
       if (ec == 0)          // otc has not been an element of om
         throw_runtime_error("destruction of unknown object", demangledClassName);
@@ -0,0 +1,177 @@
+// SequenceKernels.cpp:
+// -------------------
+// Kernels for comparing and hashing sequences as flat arrays, see
+// SequenceKernels.h. The SSE2/SSE4.2 and AVX2 variants are compiled with
+// target attributes, so no special compiler options are needed; they
+// are only called if the CPU supports them.
+// =====================================================================
+
+#include <cstring>
+#include <initializer_list>
+
+using namespace std;
+
+#include "SequenceKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+// === scalar kernels ==================================================
+
+static size_t scalarMismatch(const void *p1, const void *p2, size_t n) {
+  const unsigned char *b1 = static_cast<const unsigned char *>(p1);
+  const unsigned char *b2 = static_cast<const unsigned char *>(p2);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) { // eight bytes at a time ...
+    uint64_t w1, w2;
+    memcpy(&w1, b1 + i, 8);
+    memcpy(&w2, b2 + i, 8);
+    if (w1 != w2) {
+#if defined(__GNUC__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+      return i + __builtin_ctzll(w1 ^ w2) / 8; // first differing byte
+#else
+      break;
+#endif
+    } // if
+  } // for
+  while ( (i < n) && (b1[i] == b2[i]) ) // ... and the rest byte by byte
+    i++;
+  return i;
+} // scalarMismatch
+
+// table for CRC-32C with the reflected Castagnoli polynomial 0x82F63B78,
+//   one byte at a time, the same as the SSE4.2 crc32 instruction
+static const uint32_t *crc32cTable() {
+  static const struct Table {
+    uint32_t entries[256];
+    Table() {
+      for (uint32_t b = 0; b < 256; b++) {
+        uint32_t crc = b;
+        for (int k = 0; k < 8; k++)
+          crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0u);
+        entries[b] = crc;
+      } // for
+    } // Table
+  } table;
+  return table.entries;
+} // crc32cTable
+
+static uint32_t scalarCrc32c(uint32_t crc, const void *p, size_t n) {
+  const uint32_t *table = crc32cTable();
+  const unsigned char *b = static_cast<const unsigned char *>(p);
+  for (size_t i = 0; i < n; i++)
+    crc = table[(crc ^ b[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+} // scalarCrc32c
+
+
+#ifdef X86_KERNELS
+
+// === SSE2 and SSE4.2 kernels =========================================
+
+// 16 bytes at a time with SSE2 instructions only
+__attribute__((target("sse2")))
+static size_t sse2Mismatch(const void *p1, const void *p2, size_t n) {
+  const unsigned char *b1 = static_cast<const unsigned char *>(p1);
+  const unsigned char *b2 = static_cast<const unsigned char *>(p2);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b1 + i));
+    __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b2 + i));
+    unsigned eqMask = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+    if (eqMask != 0xFFFF)
+      return i + __builtin_ctz(~eqMask);
+  } // for
+  return i + scalarMismatch(b1 + i, b2 + i, n - i);
+} // sse2Mismatch
+
+__attribute__((target("sse4.2")))
+static uint32_t sse42Crc32c(uint32_t crc, const void *p, size_t n) {
+  const unsigned char *b = static_cast<const unsigned char *>(p);
+  size_t i = 0;
+  uint64_t crc64 = crc;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t w;
+    memcpy(&w, b + i, 8);
+    crc64 = _mm_crc32_u64(crc64, w);
+  } // for
+  crc = static_cast<uint32_t>(crc64);
+  for (; i < n; i++)
+    crc = _mm_crc32_u8(crc, b[i]);
+  return crc;
+} // sse42Crc32c
+
+
+// === AVX2 kernels ====================================================
+
+__attribute__((target("avx2")))
+static size_t avx2Mismatch(const void *p1, const void *p2, size_t n) {
+  const unsigned char *b1 = static_cast<const unsigned char *>(p1);
+  const unsigned char *b2 = static_cast<const unsigned char *>(p2);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b1 + i));
+    __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b2 + i));
+    unsigned eqMask = static_cast<unsigned>(
+                        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2)));
+    if (eqMask != 0xFFFFFFFFu)
+      return i + __builtin_ctz(~eqMask);
+  } // for
+  if (i + 16 <= n) {
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b1 + i));
+    __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b2 + i));
+    unsigned eqMask = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+    if (eqMask != 0xFFFF)
+      return i + __builtin_ctz(~eqMask);
+    i += 16;
+  } // if
+  return i + scalarMismatch(b1 + i, b2 + i, n - i);
+} // avx2Mismatch
+
+#endif // X86_KERNELS
+
+
+// === selection of kernels ============================================
+
+static const SequenceKernels scalarKernels =
+  { KernelIsa::scalar, "scalar", scalarMismatch, scalarCrc32c };
+
+#ifdef X86_KERNELS
+static const SequenceKernels sse42Kernels =  // mismatch needs SSE2 only
+  { KernelIsa::sse42,  "SSE4.2", sse2Mismatch,   sse42Crc32c  };
+static const SequenceKernels avx2Kernels =   // crc32 is an SSE4.2 instruction
+  { KernelIsa::avx2,   "AVX2",   avx2Mismatch,   sse42Crc32c  };
+#endif
+
+const SequenceKernels *sequenceKernelsFor(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::scalar:
+      return &scalarKernels;
+#ifdef X86_KERNELS
+    case KernelIsa::sse42:
+      return __builtin_cpu_supports("sse4.2") ? &sse42Kernels : nullptr;
+    case KernelIsa::avx2:
+      return (__builtin_cpu_supports("avx2") &&
+              __builtin_cpu_supports("sse4.2")) ? &avx2Kernels : nullptr;
+#endif
+    default:
+      return nullptr;
+  } // switch
+} // sequenceKernelsFor
+
+const SequenceKernels &sequenceKernels() {
+  static const SequenceKernels *best = []() {
+    for (KernelIsa isa: {KernelIsa::avx2, KernelIsa::sse42})
+      if (const SequenceKernels *k = sequenceKernelsFor(isa))
+        return k;
+    return &scalarKernels;
+  }();
+  return *best;
+} // sequenceKernels
+
+
+// end of SequenceKernels.cpp
+//======================================================================
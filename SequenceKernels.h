@@ -0,0 +1,50 @@
+// SequenceKernels.h:
+// -----------------
+// Kernels for comparing and hashing sequences as flat arrays, i.e.,
+// arrays of symbol pointers (Sequence) or of packed symbol ids
+// (PackedSequenceSet): mismatch finds the first differing byte,
+// crc32c hashes bytes. There are variants for SSE4.2 (with an SSE2
+// mismatch) and AVX2 and a portable scalar one, the best one supported
+// by the CPU is selected once at run time.
+// =====================================================================
+
+#ifndef SequenceKernels_h
+#define SequenceKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+
+enum class KernelIsa { scalar, sse42, avx2 }; // instruction set of kernels
+
+struct SequenceKernels {
+
+  KernelIsa   isa;
+  const char *name;
+
+  // index of the first byte where p1[0..n) and p2[0..n) differ, or n
+  std::size_t   (*mismatch)(const void *p1, const void *p2, std::size_t n);
+
+  // CRC-32C (Castagnoli) of p[0..n), continuing from crc; all variants
+  //   deliver the same values
+  std::uint32_t (*crc32c)(std::uint32_t crc, const void *p, std::size_t n);
+
+}; // SequenceKernels
+
+// sequences shorter than this (in symbols or packed ids) are compared
+//   with an inline loop, which is faster than calling a mismatch kernel
+//   for them: TESTCASE 11 shows the kernels winning from 16 bytes of
+//   packed ids and from about 64 bytes of symbol pointers on
+const std::size_t minLengthForMismatchKernel = 8;
+
+// the kernels for isa or nullptr if the CPU does not support isa
+const SequenceKernels *sequenceKernelsFor(KernelIsa isa);
+
+// the kernels for the best instruction set the CPU supports
+const SequenceKernels &sequenceKernels();
+
+
+#endif
+
+// end of SequenceKernels.h
+//======================================================================
@@ -3,17 +3,21 @@
 // Classes Sequence and SequenceSet for sets of Sequence objects.
 // Sequence objects represent (possibly empty) sequences of
 //   pointers to either T- or NTSymbol objects.
-// SequenceSet objects take ownership of their sequences.
+// SequenceSet objects take ownership of their sequences, so do
+//   UnorderedSequenceSet objects for deduplication by hashing.
 // =====================================================================
 
+#include <algorithm>
+#include <cctype>
 #include <cstdarg>
 
 #include <iostream>
-#include <sstream>
 #include <stdexcept>
+#include <utility>
 
 using namespace std;
 
+#include "SequenceKernels.h"
 #include "SequenceStuff.h"
 
 
@@ -22,39 +26,68 @@ void checkForNullptr(void *ptr, const char *errMsg) {
     throw invalid_argument(errMsg);
 } // checkForNullptr
 
+string_view nextToken(string_view &str) {
+  size_t i = 0;
+  while ( (i < str.length()) && isspace(static_cast<unsigned char>(str[i])) )
+    i++;
+  size_t start = i;
+  while ( (i < str.length()) && !isspace(static_cast<unsigned char>(str[i])) )
+    i++;
+  string_view token = str.substr(start, i - start);
+  str.remove_prefix(i);
+  return token;
+} // nextToken
+
 
 // === implementation of class Sequence ================================
 
-Sequence::Sequence(Symbol *sy) {
+Sequence::Sequence(const Sequence &seq)
+: /*OC+*/ ObjectCounter<Sequence>(), /*+OC*/
+  symbols(inlineSymbols), sz(0), cap(inlineCapacity) {
+  if (seq.sz > cap) {
+    symbols = new Symbol *[seq.sz];
+    cap     = seq.sz;
+  } // if
+  copy(seq.begin(), seq.end(), symbols);
+  sz = seq.sz;
+} // Sequence::Sequence
+
+Sequence::Sequence(Sequence &&seq) noexcept
+: /*OC+*/ ObjectCounter<Sequence>(), /*+OC*/
+  symbols(inlineSymbols), sz(0), cap(inlineCapacity) {
+  take(seq);
+} // Sequence::Sequence
+
+Sequence::Sequence(Symbol *sy)
+: Sequence() {
   checkForNullptr(sy, "invalid nullptr for symbol");
   push_back(sy);
 } // Sequence::Sequence
 
-Sequence::Sequence(initializer_list<Symbol *> il) {
+Sequence::Sequence(initializer_list<Symbol *> il)
+: Sequence() {
+  reserve(il.size());
   for (auto sy: il) {
     checkForNullptr(sy, "invalid nullptr for symbol");
     push_back(sy);
   } // for
 } // Sequence::Sequence
 
-Sequence::Sequence(const std::string &str) {
-  istringstream iss(str);
-  string syName;
+Sequence::Sequence(string_view str)
+: Sequence() {
   SymbolPool sp;
-  while (!iss.eof()) {
-    syName.clear();
-    iss >> syName;
-    if (syName.length() > 0) {
-      Symbol *sy = sp.symbolFor(syName);
-      checkForNullptr(sy, ("invalid symbol name \"" + syName +
-                           "\" in string").c_str());
-      push_back(sy);
-    } // if
-  } // while
+  for (string_view syName = nextToken(str); syName.length() > 0;
+                   syName = nextToken(str)) {
+    Symbol *sy = sp.symbolFor(syName);
+    checkForNullptr(sy, ("invalid symbol name \"" + string(syName) +
+                         "\" in string").c_str());
+    push_back(sy);
+  } // for
 } // Sequence::Sequence
 
 template<typename ItT>
-Sequence::Sequence(ItT begin, ItT end) {
+Sequence::Sequence(ItT begin, ItT end)
+: Sequence() {
   for (ItT it = begin; it != end; it++) {
     checkForNullptr(*it, "invalid nullptr for symbol");
     push_back(*it);
@@ -62,6 +95,67 @@ Sequence::Sequence(ItT begin, ItT end) {
 } //Sequence::Sequence
 
 
+Sequence::~Sequence() {
+  if (!isInline())
+    delete[] symbols;
+} // Sequence::~Sequence
+
+
+Sequence &Sequence::operator=(Sequence &&seq) noexcept {
+  if (this != &seq) {
+    if (!isInline())
+      delete[] symbols;
+    symbols = inlineSymbols;
+    sz      = 0;
+    cap     = inlineCapacity;
+    take(seq);
+  } // if
+  return *this;
+} // Sequence::operator=
+
+
+void Sequence::take(Sequence &seq) noexcept {
+  if (seq.isInline()) // copy the few symbols
+    copy(seq.begin(), seq.end(), symbols);
+  else {              // steal the heap array
+    symbols     = seq.symbols;
+    cap         = seq.cap;
+    seq.symbols = seq.inlineSymbols;
+    seq.cap     = inlineCapacity;
+  } // else
+  sz     = seq.sz;
+  seq.sz = 0;
+} // Sequence::take
+
+void Sequence::grow(size_type minCap) {
+  size_type newCap = max(minCap, size_type(2) * cap);
+  Symbol **newSymbols = new Symbol *[newCap];
+  copy(begin(), end(), newSymbols);
+  if (!isInline())
+    delete[] symbols;
+  symbols = newSymbols;
+  cap     = static_cast<uint32_t>(newCap);
+} // Sequence::grow
+
+Sequence::iterator Sequence::insert(const_iterator pos, const_iterator first,
+                                                        const_iterator last) {
+  size_type idx = pos - begin();
+  size_type n   = last - first; // range must not be part of this sequence
+  reserve(sz + n);
+  copy_backward(begin() + idx, end(), end() + n);
+  copy(first, last, begin() + idx);
+  sz += static_cast<uint32_t>(n);
+  return begin() + idx;
+} // Sequence::insert
+
+Sequence::iterator Sequence::erase(const_iterator pos) {
+  size_type idx = pos - begin();
+  copy(begin() + idx + 1, end(), begin() + idx);
+  sz--;
+  return begin() + idx;
+} // Sequence::erase
+
+
 void Sequence::check(int idx) const {
   if ( (0 <= idx) && (idx < length()) )
     return;
@@ -100,12 +194,12 @@ void Sequence::append(Sequence *seq) {
 
 Symbol *&Sequence::operator[](int idx) {
   check(idx);
-  return Base::operator[](static_cast<Base::size_type>(idx));
+  return symbols[idx];
 } // Sequence::operator[]
 
 Symbol *Sequence::symbolAt(int idx) const {
   check(idx);
-  return *(begin() + idx);
+  return symbols[idx];
 } // Sequence::symbolAt
 
 Symbol *Sequence::symbolAt(iterator it) const {
@@ -158,23 +252,25 @@ bool Sequence::isEpsilon() const {
   return size() == 0;
 } // Sequence::isEpsilon
 
+// ranks instead of ids, as aliased T- and NTSymbols have different ids
+//   but equal names, hence equal ranks, and are equal for operator==;
+//   ranks often have many trailing zero bits, so the high bits of
+//   each product are folded back into the low ones
+size_t Sequence::hash() const {
+  uint64_t h = sz;
+  for (const Symbol *sy: *this) {
+    h = (h + sy->rank) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+  } // for
+  h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+  return static_cast<size_t>(h ^ (h >> 32));
+} // Sequence::hash
+
 
 bool operator<(const Sequence &seq1, const Sequence &seq2) { // lexicographically
   if (&seq1 == &seq2) // identical, so ==
     return false;
-  Sequence::const_iterator it1 = seq1.begin();
-  Sequence::const_iterator it2 = seq2.begin();
-  while ( (it1 != seq1.end()) &&
-          (it2 != seq2.end()) ) {
-    int cmpRes = (*it1)->name.compare((*it2)->name);
-    if (cmpRes != 0)
-      return (cmpRes < 0);
-    // cmpRes == 0, so continue
-    it1++;
-    it2++;
-  } // while
-  return ((it1 == seq1.end()) &&
-          (it2 != seq2.end()));
+  return lexCompare(seq1, seq2) < 0;
 } // operator<
 
 bool operator==(const Sequence &seq1, const Sequence &seq2) {
@@ -183,30 +279,49 @@ bool operator==(const Sequence &seq1, const Sequence &seq2) {
   if (seq1.length() != seq2.length())
     return false;
   // same size, so compare elements
-  return equal(seq1.begin(), seq1.end(),
-               seq2.begin(),
-               EqualForSymbolPtrs());
+  return lexCompare(seq1, seq2) == 0;
 } // operator==
 
+// equal pointers mean equal symbols, so only symbols at positions where
+//   the pointers differ have to be compared; these are aliases or the
+//   first differing symbols that decide; short sequences are compared
+//   in place as calling the mismatch kernel does not pay off for them
+static size_t mismatchOfSymbols(Sequence::const_iterator it1,
+                                Sequence::const_iterator it2, size_t n) {
+  if (n < minLengthForMismatchKernel) {
+    size_t i = 0;
+    while ( (i < n) && (it1[i] == it2[i]) )
+      i++;
+    return i;
+  } // if
+  return sequenceKernels().mismatch(it1, it2, n * sizeof(Symbol *)) /
+         sizeof(Symbol *);
+} // mismatchOfSymbols
+
+int lexCompare(const Sequence &seq1, const Sequence &seq2) {
+  const size_t n = min(seq1.size(), seq2.size());
+  size_t i = 0;
+  while (i < n) {
+    i += mismatchOfSymbols(seq1.begin() + i, seq2.begin() + i, n - i);
+    if (i == n)
+      break;
+    int cmpRes = seq1.begin()[i]->compare(*seq2.begin()[i]);
+    if (cmpRes != 0)
+      return cmpRes;
+    i++; // aliases, continue after them
+  } // while
+  if (seq1.size() == seq2.size())
+    return 0;
+  return (seq1.size() < seq2.size()) ? -1 : +1;
+} // lexCompare
+
 
 bool lexLessForSequencePtrs(const Sequence* seq1, const Sequence* seq2) {
   return (*seq1) < (*seq2);
 } // lexLessForSequencePtrs
 
 bool lenLexLessForSequencePtrs(const Sequence* seq1, const Sequence* seq2) {
-  int len1 = seq1->length();
-  int len2 = seq2->length();
-  if (len1 != len2)
-   return len1 < len2;
-  // len1 == len2, same size, so compare elements
-  for (int i = 0; i < len1 /*or len2*/; i++) {
-    int cmpRes = const_cast<Sequence &>(*seq1)[i]->name.compare(
-                 const_cast<Sequence &>(*seq2)[i]->name);
-    if (cmpRes == 0) // names are equal
-      continue;
-    return (cmpRes < 0); // for different names
-  } // for
-  return false; // seq1 and seq2 are equal in length and contents
+  return LenLexLessForSequencePtrs()(seq1, seq2);
 } // lenLexLessForSequencePtrs
 
 
@@ -231,74 +346,123 @@ ostream &operator<<(ostream &os, const Sequence &seq) {
 } // operator<<
 
 
-// === implementation of class SequenceSet =============================
+// === implementation of class UnorderedSequenceSet ====================
 
-SequenceSet::SequenceSet()
-: Base(lexLessForSequencePtrs) {
-  // nothing left do do
-} // SequenceSet::SequenceSet
+UnorderedSequenceSet::UnorderedSequenceSet(UnorderedSequenceSet &&uss) noexcept
+: /*OC+*/ ObjectCounter<UnorderedSequenceSet>(), /*+OC*/
+  seqs(std::move(uss.seqs)), hashes(std::move(uss.hashes)),
+  slots(std::move(uss.slots)) {
+  // nothing left to do, moved vectors of uss are empty
+} // UnorderedSequenceSet::UnorderedSequenceSet
 
-SequenceSet::SequenceSet(const SequenceSet &ss)
-: Base(lexLessForSequencePtrs) /*OC+*/ , ObjectCounter<SequenceSet>() /*+OC*/ {
-  // make a deep copy: init. Base with copies of elements in ss
-  for (auto &seq: ss) {
-    insert(new Sequence(*seq));
-  } // for
-} // SequenceSet::SequenceSet
-
-SequenceSet::SequenceSet(Sequence *s)
-: Base(lexLessForSequencePtrs) {
-  checkForNullptr(s, "invalid nullptr for sequence");
-  insert(s);
-} // SequenceSet::SequenceSet
-
-SequenceSet::SequenceSet(std::initializer_list<Sequence *> il)
-: Base(lexLessForSequencePtrs) {
-  for (Sequence *s: il) {
-    checkForNullptr(s, "invalid nullptr for sequence");
-    cout << "inserting " << *s << endl;
-    insert(s);
+UnorderedSequenceSet::~UnorderedSequenceSet() {
+  for (Sequence *seq: seqs) {
+    delete seq;
   } // for
-} // SequenceSet::SequenceSet
-
-
-SequenceSet::SequenceSet(SequencePtrCmp seqPtrCmp)
-: Base(seqPtrCmp) {
-  checkForNullptr((void*)seqPtrCmp, "invalid nullptr for sequence comparison");
-} // SequenceSet::SequenceSet
+} // UnorderedSequenceSet::~UnorderedSequenceSet
 
-
-SequenceSet::~SequenceSet() {
-  for (auto &seq: *this) {
-    delete seq;
+UnorderedSequenceSet &UnorderedSequenceSet::operator=(
+                        UnorderedSequenceSet &&uss) noexcept {
+  if (this != &uss) {
+    for (Sequence *seq: seqs) {
+      delete seq;
+    } // for
+    seqs   = std::move(uss.seqs);
+    hashes = std::move(uss.hashes);
+    slots  = std::move(uss.slots);
+    uss.seqs.clear();
+    uss.hashes.clear();
+    uss.slots.clear();
+  } // if
+  return *this;
+} // UnorderedSequenceSet::operator=
+
+
+size_t UnorderedSequenceSet::slotFor(const Sequence &seq, size_t hash) const {
+  const size_t mask = slots.size() - 1;
+  size_t i = hash & mask;
+  while (slots[i] != 0) {
+    size_t idx = slots[i] - 1;
+    if ( (hashes[idx] == hash) && (*seqs[idx] == seq) )
+      break;
+    i = (i + 1) & mask;
+  } // while
+  return i;
+} // UnorderedSequenceSet::slotFor
+
+void UnorderedSequenceSet::rehash(size_t nrOfSlots) {
+  slots.assign(nrOfSlots, 0);
+  const size_t mask = nrOfSlots - 1;
+  for (size_t idx = 0; idx < seqs.size(); idx++) {
+    size_t i = hashes[idx] & mask; // no duplicates, so only free slots needed
+    while (slots[i] != 0)
+      i = (i + 1) & mask;
+    slots[i] = static_cast<uint32_t>(idx + 1);
   } // for
-} // SequenceSet::~SequenceSet
+} // UnorderedSequenceSet::rehash
 
+bool UnorderedSequenceSet::contains(const Sequence &seq) const {
+  if (slots.empty())
+    return false;
+  return slots[slotFor(seq, seq.hash())] != 0;
+} // UnorderedSequenceSet::contains
 
-void SequenceSet::insertOrDelete(Sequence *&s) {
-  checkForNullptr(s, "invalid nullptr for sequence");
-  auto ir = insert(s);
-  if (!ir.second) { // s has not been inserted, so it's a duplicate
+pair<Sequence *, bool> UnorderedSequenceSet::insert(Sequence *seq) {
+  checkForNullptr(seq, "invalid nullptr for sequence");
+  if (2 * (seqs.size() + 1) > slots.size())
+    rehash(slots.empty() ? 16 : 2 * slots.size());
+  size_t hash = seq->hash();
+  size_t i = slotFor(*seq, hash);
+  if (slots[i] != 0) // a duplicate
+    return make_pair(seqs[slots[i] - 1], false);
+  seqs.push_back(seq);
+  hashes.push_back(hash);
+  slots[i] = static_cast<uint32_t>(seqs.size());
+  return make_pair(seq, true);
+} // UnorderedSequenceSet::insert
+
+pair<Sequence *, bool> UnorderedSequenceSet::insert(Sequence &&seq) {
+  if (2 * (seqs.size() + 1) > slots.size())
+    rehash(slots.empty() ? 16 : 2 * slots.size());
+  size_t hash = seq.hash();
+  size_t i = slotFor(seq, hash);
+  if (slots[i] != 0) // a duplicate
+    return make_pair(seqs[slots[i] - 1], false);
+  seqs.push_back(new Sequence(std::move(seq)));
+  hashes.push_back(hash);
+  slots[i] = static_cast<uint32_t>(seqs.size());
+  return make_pair(seqs.back(), true);
+} // UnorderedSequenceSet::insert
+
+void UnorderedSequenceSet::insertOrDelete(Sequence *&s) {
+  if (!insert(s).second) { // s has not been inserted, so it's a duplicate
     delete s;
     s = nullptr;
   } // if
-} // SequenceSet::insertOrDelete
-
-
-bool operator==(const SequenceSet &ss1, const SequenceSet &ss2) {
-  if (&ss1 == &ss2)
-    return true;
-  if (ss1.size() != ss2.size())
-    return false;
-  return equal(ss1.begin(), ss1.end(),
-               ss2.begin(),
-               equalForSequencePtrs);
-} // operator==
-
-ostream &operator<<(ostream &os, const SequenceSet &ss) {
+} // UnorderedSequenceSet::insertOrDelete
+
+void UnorderedSequenceSet::reindex() {
+  for (size_t idx = 0; idx < seqs.size(); idx++)
+    hashes[idx] = seqs[idx]->hash();
+  if (!slots.empty())
+    rehash(slots.size());
+} // UnorderedSequenceSet::reindex
+
+vector<Sequence *> UnorderedSequenceSet::release() {
+  vector<Sequence *> result = std::move(seqs);
+  seqs.clear();
+  hashes.clear();
+  slots.clear();
+  return result;
+} // UnorderedSequenceSet::release
+
+
+ostream &operator<<(ostream &os, const UnorderedSequenceSet &uss) {
+  vector<Sequence *> sorted(uss.begin(), uss.end());
+  sort(sorted.begin(), sorted.end(), LexLessForSequencePtrs());
   os << "{ ";
   bool first = true;
-  for (auto &seq: ss) {
+  for (const Sequence *seq: sorted) {
     if (!first)
       os << ", ";
     os << *seq;
@@ -309,6 +473,216 @@ ostream &operator<<(ostream &os, const SequenceSet &ss) {
 } // operator<<
 
 
+// === implementation of class PackedSequence ==========================
+
+size_t PackedSequence::hash() const {
+  return sequenceKernels().crc32c(len, words,
+                                  nrOfWords() * sizeof(uint16_t));
+} // PackedSequence::hash
+
+int PackedSequence::mismatch(const PackedSequence &ps, int from) const {
+  const int n = min(length(), ps.length());
+  if (from >= n)
+    return n;
+  const uint16_t *w1 = words    + from * wordsPerId;
+  const uint16_t *w2 = ps.words + from * wordsPerId;
+  if (static_cast<size_t>(n - from) < minLengthForMismatchKernel) {
+    const int nrOfWords = (n - from) * wordsPerId; // compared in place
+    int i = 0;
+    while ( (i < nrOfWords) && (w1[i] == w2[i]) )
+      i++;
+    return from + i / wordsPerId;
+  } // if
+  const size_t bytesPerId = wordsPerId * sizeof(uint16_t);
+  return from + static_cast<int>(
+    sequenceKernels().mismatch(w1, w2, (n - from) * bytesPerId) / bytesPerId);
+} // PackedSequence::mismatch
+
+bool PackedSequence::operator==(const PackedSequence &ps) const {
+  return (len == ps.len) && (mismatch(ps) == length());
+} // PackedSequence::operator==
+
+bool PackedSequence::equals(const Sequence &seq) const {
+  if (seq.size() != len)
+    return false;
+  for (int i = 0; i < length(); i++)
+    if (seq.symbolAt(i)->id != idAt(i))
+      return false;
+  return true;
+} // PackedSequence::equals
+
+Sequence PackedSequence::toSequence() const {
+  SymbolPool sp;
+  Sequence seq;
+  seq.reserve(len);
+  for (int i = 0; i < length(); i++)
+    seq.push_back(sp.symbolWithId(idAt(i)));
+  return seq;
+} // PackedSequence::toSequence
+
+
+// === implementation of class PackedIds ===============================
+
+PackedIds::PackedIds(const Sequence &seq, uint32_t wordsPerId)
+: words(inlineWords), len(static_cast<uint32_t>(seq.size())),
+  wordsPerId(wordsPerId), representable(true) {
+  if (size_t(len) * wordsPerId > inlineCapacity) {
+    heapWords.resize(size_t(len) * wordsPerId);
+    words = heapWords.data();
+  } // if
+  uint16_t *w = words;
+  for (const Symbol *sy: seq) {
+    *w++ = static_cast<uint16_t>(sy->id);
+    if (wordsPerId == 2)
+      *w++ = static_cast<uint16_t>(sy->id >> 16);
+    else if (sy->id > 0xFFFF)
+      representable = false;
+  } // for
+} // PackedIds::PackedIds
+
+
+// === implementation of class PackedSequenceSet =======================
+
+PackedSequenceSet::PackedSequenceSet()
+: wordsPerId(1), offsets(1, 0) {
+  // nothing left to do
+} // PackedSequenceSet::PackedSequenceSet
+
+PackedSequenceSet::PackedSequenceSet(PackedSequenceSet &&pss) noexcept
+: /*OC+*/ ObjectCounter<PackedSequenceSet>(), /*+OC*/
+  wordsPerId(pss.wordsPerId), words(std::move(pss.words)),
+  offsets(std::move(pss.offsets)), slots(std::move(pss.slots)) {
+  pss.wordsPerId = 1; // moved vectors of pss are empty, so is pss
+} // PackedSequenceSet::PackedSequenceSet
+
+PackedSequenceSet &PackedSequenceSet::operator=(
+                     PackedSequenceSet &&pss) noexcept {
+  if (this != &pss) {
+    wordsPerId = pss.wordsPerId;
+    words      = std::move(pss.words);
+    offsets    = std::move(pss.offsets);
+    slots      = std::move(pss.slots);
+    pss.wordsPerId = 1;
+    pss.words.clear();
+    pss.offsets.clear(); // pss is empty, see size
+    pss.slots.clear();
+  } // if
+  return *this;
+} // PackedSequenceSet::operator=
+
+size_t PackedSequenceSet::slotFor(const PackedSequence &ps, size_t hash) const {
+  const size_t mask = slots.size() - 1;
+  size_t i = hash & mask;
+  while ( (slots[i] != 0) && !((*this)[slots[i] - 1] == ps) )
+    i = (i + 1) & mask;
+  return i;
+} // PackedSequenceSet::slotFor
+
+void PackedSequenceSet::rehash(size_t nrOfSlots) {
+  slots.assign(nrOfSlots, 0);
+  const size_t mask = nrOfSlots - 1;
+  for (size_t idx = 0; idx < size(); idx++) {
+    size_t i = (*this)[idx].hash() & mask;
+    while (slots[i] != 0) // no duplicates, so only free slots needed
+      i = (i + 1) & mask;
+    slots[i] = static_cast<uint32_t>(idx + 1);
+  } // for
+} // PackedSequenceSet::rehash
+
+void PackedSequenceSet::widen() {
+  vector<uint16_t> newWords;
+  newWords.reserve(2 * words.size());
+  for (uint16_t w: words) {
+    newWords.push_back(w);
+    newWords.push_back(0); // high word
+  } // for
+  words.swap(newWords);
+  for (uint32_t &o: offsets)
+    o *= 2;
+  wordsPerId = 2;
+  if (!slots.empty()) // hashes of the words have changed
+    rehash(slots.size());
+} // PackedSequenceSet::widen
+
+
+Sequence PackedSequenceSet::sequenceAt(size_t idx) const {
+  PackedSequence ps = (*this)[idx];
+  Sequence seq;
+  seq.reserve(ps.length());
+  for (int i = 0; i < ps.length(); i++)
+    seq.push_back(sp.symbolWithId(ps.idAt(i)));
+  return seq;
+} // PackedSequenceSet::sequenceAt
+
+bool PackedSequenceSet::insert(const Sequence &seq) {
+  PackedIds ids(seq, wordsPerId);
+  if (!ids.isRepresentable()) { // an id >= 2^16, so seq is not in the set
+    widen();
+    return insert(seq);
+  } // if
+  if (2 * (size() + 1) > slots.size())
+    rehash(slots.empty() ? 16 : 2 * slots.size());
+  PackedSequence ps = ids.view();
+  size_t i = slotFor(ps, ps.hash());
+  if (slots[i] != 0) // a duplicate
+    return false;
+  if (offsets.empty()) // moved from
+    offsets.push_back(0);
+  words.insert(words.end(), ps.data(), ps.data() + ps.nrOfWords());
+  offsets.push_back(static_cast<uint32_t>(words.size()));
+  slots[i] = static_cast<uint32_t>(size());
+  return true;
+} // PackedSequenceSet::insert
+
+bool PackedSequenceSet::contains(const Sequence &seq) const {
+  if (slots.empty())
+    return false;
+  PackedIds ids(seq, wordsPerId);
+  if (!ids.isRepresentable())
+    return false;
+  PackedSequence ps = ids.view();
+  return slots[slotFor(ps, ps.hash())] != 0;
+} // PackedSequenceSet::contains
+
+void PackedSequenceSet::sort() {
+  vector<uint32_t> order(size()); // indices of sequences in sorted order
+  for (size_t idx = 0; idx < order.size(); idx++)
+    order[idx] = static_cast<uint32_t>(idx);
+  std::sort(order.begin(), order.end(), [this](uint32_t idx1, uint32_t idx2) {
+    PackedSequence ps1 = (*this)[idx1];
+    PackedSequence ps2 = (*this)[idx2];
+    int n = min(ps1.length(), ps2.length());
+    for (int i = ps1.mismatch(ps2); i < n; i = ps1.mismatch(ps2, i + 1)) {
+      int cmpRes = sp.symbolWithId(ps1.idAt(i))->compare(
+                  *sp.symbolWithId(ps2.idAt(i)));
+      if (cmpRes != 0) // by ranks of symbols, aliases are equal
+        return (cmpRes < 0);
+    } // for
+    return ps1.length() < ps2.length();
+  });
+  vector<uint16_t> newWords;
+  vector<uint32_t> newOffsets;
+  newWords.reserve(words.size());
+  newOffsets.reserve(offsets.size());
+  newOffsets.push_back(0);
+  for (uint32_t idx: order) {
+    newWords.insert(newWords.end(), words.begin() + offsets[idx],
+                                    words.begin() + offsets[idx + 1]);
+    newOffsets.push_back(static_cast<uint32_t>(newWords.size()));
+  } // for
+  words.swap(newWords);
+  offsets.swap(newOffsets);
+  if (!slots.empty())
+    rehash(slots.size());
+} // PackedSequenceSet::sort
+
+size_t PackedSequenceSet::nrOfBytes() const {
+  return sizeof(*this) + words.capacity()   * sizeof(uint16_t) +
+                         offsets.capacity() * sizeof(uint32_t) +
+                         slots.capacity()   * sizeof(uint32_t);
+} // PackedSequenceSet::nrOfBytes
+
+
 // === test ============================================================
 
 #if 0
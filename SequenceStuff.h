@@ -3,15 +3,26 @@
 // Classes Sequence and SequenceSet for sets of Sequence objects.
 // Sequence objects represent (possibly empty) sequences of
 //   pointers to T- and/or NTSymbol objects.
-// SequenceSet objects take ownership of their sequences.
+// SequenceSet objects take ownership of their sequences, so do
+//   UnorderedSequenceSet objects for deduplication by hashing.
+// SequenceSets are flat sorted vectors, see class template
+//   BasicSequenceSet below.
+// PackedSequenceSet objects store many sequences compactly as ids of
+//   symbols in one buffer, PackedSequences are views of these and
+//   PackedIds pack the ids of a Sequence the same way.
 // =====================================================================
 
 #ifndef SequenceStuff_h
 #define SequenceStuff_h
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
+#include <iostream>
 #include <memory>
-#include <set>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "ObjectCounter.h"
@@ -22,37 +33,106 @@
 //   throws invalid_argument(errMsg) when ptr == nullptr
 void checkForNullptr(void *ptr, const char *errMsg);
 
+// simple global utility function also used in other modules
+//   returns the next white space separated token in str as a view
+//   into str and removes it from str, returns an empty view at the end
+std::string_view nextToken(std::string_view &str);
+
 
 // === class Sequence ==================================================
+//
+// Sequences store up to inlineCapacity symbols within the object itself
+// (small buffer optimization), so the typical short right-hand sides of
+// rules and sentential forms need no heap allocation; only longer
+// sequences move their symbols to an array on the heap.
+// The interface is the one of the former base class std::vector, at
+// least as far as it is used for Sequences.
+
+class Sequence final // no public base class
+      /*OC+*/ : private ObjectCounter<Sequence> /*+OC*/ {
+
+  public:
+
+    typedef Symbol *           value_type;
+    typedef Symbol *&          reference;
+    typedef Symbol * const &   const_reference;
+    typedef Symbol **          iterator;
+    typedef Symbol * const *   const_iterator;
+    typedef std::size_t        size_type;
+    typedef std::ptrdiff_t     difference_type;
 
-class Sequence: public std::vector<Symbol *>
-      /*OC+*/ , private ObjectCounter<Sequence> /*+OC*/ {
+    // nr. of symbols without heap allocation, so that the data components
+    //   take 64 bytes (one cache line) on 64 bit platforms
+    static const size_type inlineCapacity = 6;
 
   private:
 
-    typedef std::vector<Symbol *> Base;
+    Symbol      **symbols;      // inlineSymbols or array on heap
+    std::uint32_t sz;           // nr. of symbols
+    std::uint32_t cap;          // nr. of symbols without reallocation
+    Symbol       *inlineSymbols[inlineCapacity];
 
     Sequence &operator=(const Sequence &seq) = delete;
 
     void check(int      idx) const;
     void check(iterator it ) const;
 
-  public:
+    bool isInline() const {
+      return symbols == inlineSymbols;
+    } // isInline
 
-    typedef Base::iterator iterator;
+    void grow(size_type minCap); // moves symbols to a larger heap array
 
-    Sequence() = default; // constructs an empty Sequence aka epsilon
-    Sequence(const Sequence &seq) = default;
+    void take(Sequence &seq) noexcept; // symbols of seq, this is empty
+
+  public:
+
+    Sequence() // constructs an empty Sequence aka epsilon
+    : symbols(inlineSymbols), sz(0), cap(inlineCapacity) {
+    } // Sequence
+    Sequence(const Sequence &seq);
+    Sequence(Sequence &&seq) noexcept; // leaves seq empty
     Sequence(Symbol *sy);
     Sequence(std::initializer_list<Symbol *> il);
 
-    Sequence(const std::string &str); // based on existing symbols in SymbolPool,
+    Sequence(std::string_view str); // based on existing symbols in SymbolPool,
       // e.g., "a B" => Sequence({sp->symbolFor("a"), sp->symbolFor("B")})
 
     template<typename ItT>
     Sequence(ItT begin, ItT end);
 
-    virtual ~Sequence() = default;
+    ~Sequence(); // not virtual because of final class
+
+    Sequence &operator=(Sequence &&seq) noexcept; // leaves seq empty
+
+    // vector-like interface for iteration and modification
+
+    iterator       begin()       { return symbols;      }
+    iterator       end()         { return symbols + sz; }
+    const_iterator begin() const { return symbols;      }
+    const_iterator end()   const { return symbols + sz; }
+
+    size_type size()  const { return sz;      }
+    bool      empty() const { return sz == 0; }
+
+    void push_back(Symbol *sy) {
+      if (sz == cap)
+        grow(sz + 1);
+      symbols[sz++] = sy;
+    } // push_back
+
+    void reserve(size_type n) {
+      if (n > cap)
+        grow(n);
+    } // reserve
+
+    void clear() { sz = 0; } // keeps the capacity, e.g., for scratch sequences
+
+    iterator insert(const_iterator pos, const_iterator first,
+                                        const_iterator last);
+    iterator erase(const_iterator pos);
+
+    // Sequence-specific interface
 
     int length() const; // nr. of terminal and nonterminal symbols
     int terminalLength() const; // nr. of terminal symbols only
@@ -77,57 +157,449 @@ class Sequence: public std::vector<Symbol *>
 
     bool isEpsilon() const; // <=> length() == 0
 
+    // hash value based on the ranks of the symbols, so it is consistent
+    //   with operator== and the same for equal sequences in all pools
+    std::size_t hash() const;
+
 }; // Sequence
 
 bool operator< (const Sequence &seq1, const Sequence &seq2); // lexicographically
 bool operator==(const Sequence &seq1, const Sequence &seq2);
 
+// compares lexicographically by ranks (names) of symbols and returns
+//   < 0, 0 or > 0; the first differing symbols are found by comparing
+//   the arrays of symbol pointers with the mismatch kernel
+int lexCompare(const Sequence &seq1, const Sequence &seq2);
+
 // compares lexicographically as operator< from above
 bool lexLessForSequencePtrs(const Sequence *seq1, const Sequence *seq2);
 
 // compares 1. lengths and 2. lexicographically for equal lengths
 bool lenLexLessForSequencePtrs(const Sequence *seq1, const Sequence *seq2);
 
+// function objects for the comparisons from above, e.g. as template
+//   parameters for BasicSequenceSet
+struct LexLessForSequencePtrs {
+  bool operator()(const Sequence *seq1, const Sequence *seq2) const {
+    return lexCompare(*seq1, *seq2) < 0;
+  } // operator()
+}; // LexLessForSequencePtrs
+
+struct LenLexLessForSequencePtrs {
+  bool operator()(const Sequence *seq1, const Sequence *seq2) const {
+    if (seq1->size() != seq2->size())
+      return seq1->size() < seq2->size();
+    return LexLessForSequencePtrs()(seq1, seq2);
+  } // operator()
+}; // LenLexLessForSequencePtrs
+
 bool equalForSequencePtrs(const Sequence *seq1, const Sequence *seq2);
 
+struct HashForSequencePtrs {   // for unordered containers of Sequence *
+  std::size_t operator()(const Sequence *seq) const {
+    return seq->hash();
+  } // operator()
+}; // HashForSequencePtrs
+
+struct EqualForSequencePtrs {  // for unordered containers of Sequence *
+  bool operator()(const Sequence *seq1, const Sequence *seq2) const {
+    return equalForSequencePtrs(seq1, seq2);
+  } // operator()
+}; // EqualForSequencePtrs
+
 std::ostream &operator<<(std::ostream &os, const Sequence &seq);
 
 
-// === class SequenceSet ===============================================
-//           SequenceSets take ownership of their Sequences
+// === class template BasicSequenceSet ================================
+//           BasicSequenceSets take ownership of their Sequences
+//
+// Flat sets: the sequences are kept in a vector sorted according to
+// the comparator Cmp, which is a template parameter so that comparisons
+// can be inlined. Single insertions cost O(n), so large sets should be
+// built in bulk: all sequences are collected in a vector and passed
+// to the constructor or to insertOrDelete, which sort only once.
 
-typedef bool (*SequencePtrCmp)(const Sequence *seq1, const Sequence *seq2);
+template <typename Cmp>
+class BasicSequenceSet final // no public base class
+       /*OC+*/ : private ObjectCounter<BasicSequenceSet<Cmp>> /*+OC*/ {
 
-class SequenceSet: public  std::set<Sequence *, SequencePtrCmp>
-         /*OC+*/ , private ObjectCounter<SequenceSet> /*+OC*/ {
+  private:
+
+    std::vector<Sequence *> seqs; // sorted according to Cmp, no duplicates
+
+    BasicSequenceSet &operator=(const BasicSequenceSet &ss) = delete;
+
+    static bool equivalent(const Sequence *seq1, const Sequence *seq2) {
+      return !Cmp()(seq1, seq2) && !Cmp()(seq2, seq1);
+    } // equivalent
+
+  public:
+
+    typedef std::vector<Sequence *>::const_iterator const_iterator;
+    typedef const_iterator iterator; // elements must not be changed
+
+    BasicSequenceSet() = default;
+
+    BasicSequenceSet(const BasicSequenceSet &ss) // makes a deep copy
+    /*OC+*/ : ObjectCounter<BasicSequenceSet<Cmp>>() /*+OC*/ {
+      seqs.reserve(ss.size());
+      for (const Sequence *seq: ss)
+        seqs.push_back(new Sequence(*seq)); // ss is sorted, so is seqs
+    } // BasicSequenceSet
+
+    BasicSequenceSet(BasicSequenceSet &&ss) noexcept // takes over sequences
+    : /*OC+*/ ObjectCounter<BasicSequenceSet<Cmp>>(), /*+OC*/
+      seqs(std::move(ss.seqs)) {
+      ss.seqs.clear();
+    } // BasicSequenceSet
+
+    BasicSequenceSet(Sequence *s) {
+      checkForNullptr(s, "invalid nullptr for sequence");
+      seqs.push_back(s);
+    } // BasicSequenceSet
+
+    BasicSequenceSet(std::initializer_list<Sequence *> il) {
+      for (Sequence *s: il) {
+        checkForNullptr(s, "invalid nullptr for sequence");
+        std::cout << "inserting " << *s << std::endl;
+        insert(s);
+      } // for
+    } // BasicSequenceSet
+
+    // bulk construction: takes ownership of all sequences in newSeqs,
+    //   sorts them once and deletes duplicates
+    explicit BasicSequenceSet(std::vector<Sequence *> &&newSeqs) {
+      insertOrDelete(std::move(newSeqs));
+    } // BasicSequenceSet
+
+    ~BasicSequenceSet() { // not virtual because of final class,
+      for (Sequence *seq: seqs) // also deletes its elements (sequences)
+        delete seq;
+    } // ~BasicSequenceSet
+
+    BasicSequenceSet &operator=(BasicSequenceSet &&ss) noexcept {
+      if (this != &ss) {        // deletes own sequences ...
+        for (Sequence *seq: seqs)
+          delete seq;
+        seqs = std::move(ss.seqs); // ... and takes over those of ss
+        ss.seqs.clear();
+      } // if
+      return *this;
+    } // operator=
+
+    const_iterator begin() const { return seqs.begin(); }
+    const_iterator end()   const { return seqs.end();   }
+
+    std::size_t size()  const { return seqs.size();  }
+    bool        empty() const { return seqs.empty(); }
+
+    const_iterator find(const Sequence *seq) const {
+      auto it = std::lower_bound(seqs.begin(), seqs.end(), seq, Cmp());
+      return ( (it != seqs.end()) && !Cmp()(seq, *it) ) ? it : seqs.end();
+    } // find
+
+    // takes ownership of seq only if it has been inserted, as for std::set
+    std::pair<const_iterator, bool> insert(Sequence *seq) {
+      checkForNullptr(seq, "invalid nullptr for sequence");
+      auto it = std::lower_bound(seqs.begin(), seqs.end(), seq, Cmp());
+      if ( (it != seqs.end()) && !Cmp()(seq, *it) ) // a duplicate
+        return std::make_pair(const_iterator(it), false);
+      return std::make_pair(const_iterator(seqs.insert(it, seq)), true);
+    } // insert
+
+    void insertOrDelete(Sequence *&s) { // insert s into set or ...
+      if (!insert(s).second) {          // ... delete s if it's already there
+        delete s;
+        s = nullptr;
+      } // if
+    } // insertOrDelete
+
+    // bulk insertion: takes ownership of all sequences in newSeqs,
+    //   sorts once and deletes duplicates (also those already in set)
+    void insertOrDelete(std::vector<Sequence *> &&newSeqs) {
+      for (Sequence *s: newSeqs)
+        checkForNullptr(s, "invalid nullptr for sequence");
+      std::size_t oldSize = seqs.size();
+      seqs.insert(seqs.end(), newSeqs.begin(), newSeqs.end());
+      newSeqs.clear();
+      std::stable_sort(seqs.begin() + oldSize, seqs.end(), Cmp());
+      std::inplace_merge(seqs.begin(), seqs.begin() + oldSize, seqs.end(), Cmp());
+      auto last = seqs.begin(); // keep first of equivalent sequences
+      for (auto it = seqs.begin(); it != seqs.end(); it++) {
+        if ( (it != seqs.begin()) && equivalent(*(last - 1), *it) )
+          delete *it;
+        else
+          *last++ = *it;
+      } // for
+      seqs.erase(last, seqs.end());
+    } // insertOrDelete
+
+}; // BasicSequenceSet
+
+template <typename Cmp>
+bool operator==(const BasicSequenceSet<Cmp> &ss1,
+                const BasicSequenceSet<Cmp> &ss2) {
+  if (&ss1 == &ss2)
+    return true;
+  if (ss1.size() != ss2.size())
+    return false;
+  return std::equal(ss1.begin(), ss1.end(),
+                    ss2.begin(),
+                    equalForSequencePtrs);
+} // operator==
+
+template <typename Cmp>
+std::ostream &operator<<(std::ostream &os, const BasicSequenceSet<Cmp> &ss) {
+  os << "{ ";
+  bool first = true;
+  for (const Sequence *seq: ss) {
+    if (!first)
+      os << ", ";
+    os << *seq;
+    first = false;
+  } // for
+  os << " }" << std::endl;
+  return os;
+} // operator<<
+
+// the default SequenceSet with lexicographic order, e.g. for RulesMap
+typedef BasicSequenceSet<   LexLessForSequencePtrs> SequenceSet;
+typedef BasicSequenceSet<LenLexLessForSequencePtrs> LenLexSequenceSet;
+
+
+// === class UnorderedSequenceSet ======================================
+//           UnorderedSequenceSets take ownership of their Sequences
+//
+// For workloads that only need deduplication: an open addressing hash
+// table (linear probing, load factor <= 1/2) of indices into a vector
+// of sequences, iteration is in order of insertion or, after a final
+// call of sort, in sorted order.
+
+class UnorderedSequenceSet final // no public base class
+         /*OC+*/ : private ObjectCounter<UnorderedSequenceSet> /*+OC*/ {
 
   private:
 
-    typedef std::set<Sequence *, SequencePtrCmp> Base;
+    std::vector<Sequence *>    seqs;   // in order of insertion (or sorted)
+    std::vector<std::size_t>   hashes; // hashes[i] == seqs[i]->hash()
+    std::vector<std::uint32_t> slots;  // 0 for a free slot or 1 + index
+                                       //   into seqs, size is a power of 2
 
-    SequenceSet &operator=(const SequenceSet &ss) = delete;
+    UnorderedSequenceSet(const UnorderedSequenceSet &uss) = delete;
+    UnorderedSequenceSet &operator=(const UnorderedSequenceSet &uss) = delete;
+
+    // slot containing seq or the free slot where to insert it
+    std::size_t slotFor(const Sequence &seq, std::size_t hash) const;
+
+    void rehash(std::size_t nrOfSlots);
+
+    void reindex(); // hashes and slots after reordering of seqs
 
   public:
 
-    // constructors installing lexLessForSequencePtrs for std::set
-    SequenceSet();
-    SequenceSet(const SequenceSet &ss); // makes a deep copy
-    SequenceSet(Sequence *s);
-    SequenceSet(std::initializer_list<Sequence *> il);
+    typedef std::vector<Sequence *>::const_iterator const_iterator;
+    typedef const_iterator iterator; // elements must not be changed
+
+    UnorderedSequenceSet() = default;
+    UnorderedSequenceSet(UnorderedSequenceSet &&uss) noexcept; // leaves uss empty
+
+    ~UnorderedSequenceSet(); // not virtual because of final class,
+                             //   also deletes its elements (sequences)
+
+    UnorderedSequenceSet &operator=(UnorderedSequenceSet &&uss) noexcept;
 
-    // constructor allowing different sorting gorder, e.g lenlexLessForSequencePtrs
-    SequenceSet(SequencePtrCmp seqPtrCmp);
+    const_iterator begin() const { return seqs.begin(); }
+    const_iterator end()   const { return seqs.end();   }
 
-    virtual ~SequenceSet(); // also deletes its elements (sequences)
+    std::size_t size()  const { return seqs.size();  }
+    bool        empty() const { return seqs.empty(); }
 
-    void insertOrDelete(Sequence *&s); // insert s into SequenceSet or ...
+    bool contains(const Sequence &seq) const;
+
+    // both inserts return the sequence in the set and true if inserted,
+    //   1. takes ownership of seq only if inserted, see insertOrDelete
+    //   2. allocates a new Sequence (from seq) only if inserted
+    std::pair<Sequence *, bool> insert(Sequence  *seq);
+    std::pair<Sequence *, bool> insert(Sequence &&seq);
+
+    void insertOrDelete(Sequence *&s); // insert s into set or ...
                                        // ... delete s if it's already there
 
-}; // SequenceSet
+    // final sort: changes the order of iteration, e.g. for output
+    template <typename Cmp = LexLessForSequencePtrs>
+    void sort(Cmp cmp = Cmp()) {
+      std::sort(seqs.begin(), seqs.end(), cmp);
+      reindex();
+    } // sort
+
+    // hands over all sequences (in order of iteration), leaves set empty
+    std::vector<Sequence *> release();
+
+}; // UnorderedSequenceSet
+
+// outputs sequences in lexicographic order as operator<< for SequenceSet
+std::ostream &operator<<(std::ostream &os, const UnorderedSequenceSet &uss);
+
+
+// === class PackedSequence ============================================
+//
+// View of a sequence in a PackedSequenceSet: the ids of its symbols
+// use one 16 bit word each or, for large symbol pools, two words each.
+// Views are valid as long as their PackedSequenceSet is not changed.
+// Hashing and comparison work on the words with the kernels from
+// SequenceKernels.h.
+
+class PackedSequence final { // no public base class, no object counting
+
+  private:
+
+    const std::uint16_t *words;
+    std::uint32_t        len;        // nr. of ids (symbols)
+    std::uint32_t        wordsPerId; // 1 or 2
+
+  public:
+
+    PackedSequence(const std::uint16_t *words, std::uint32_t len,
+                   std::uint32_t wordsPerId)
+    : words(words), len(len), wordsPerId(wordsPerId) {
+    } // PackedSequence
+
+    int length() const {
+      return static_cast<int>(len);
+    } // length
+
+    const std::uint16_t *data() const {
+      return words;
+    } // data
+
+    std::size_t nrOfWords() const {
+      return std::size_t(len) * wordsPerId;
+    } // nrOfWords
+
+    std::uint32_t idAt(int idx) const {
+      if (wordsPerId == 1)
+        return words[idx];
+      return words[2 * idx] | (std::uint32_t(words[2 * idx + 1]) << 16);
+    } // idAt
+
+    std::size_t hash() const; // CRC-32C of the words
+
+    // index of the first id at or after from where this and ps (with the
+    //   same nr. of words per id) differ, or the length of the shorter one
+    int mismatch(const PackedSequence &ps, int from = 0) const;
+
+    // same ids, ps must use the same nr. of words per id
+    bool operator==(const PackedSequence &ps) const;
+
+    bool equals(const Sequence &seq) const; // same symbols as seq
+
+    Sequence toSequence() const; // with the symbols from the SymbolPool
+
+}; // PackedSequence
+
+
+// === class PackedIds =================================================
+//
+// Packed symbol-id view of a Sequence: its ids encoded as in a
+// PackedSequenceSet, so that it can be hashed and compared with the
+// sequences in the set; the words of short sequences are kept in the
+// object itself.
+
+class PackedIds final { // no public base class, no object counting
+
+  private:
+
+    static const std::size_t inlineCapacity = 64; // nr. of words
+
+    std::uint16_t              inlineWords[inlineCapacity];
+    std::vector<std::uint16_t> heapWords; // for long sequences only
+    std::uint16_t             *words;
+    std::uint32_t              len;
+    std::uint32_t              wordsPerId;
+    bool                       representable; // all ids fit into wordsPerId
+
+    PackedIds(const PackedIds &pi) = delete;
+    PackedIds &operator=(const PackedIds &pi) = delete;
+
+  public:
+
+    PackedIds(const Sequence &seq, std::uint32_t wordsPerId);
+
+    // false if an id >= 2^16 does not fit into one word per id
+    bool isRepresentable() const {
+      return representable;
+    } // isRepresentable
+
+    PackedSequence view() const {
+      return PackedSequence(words, len, wordsPerId);
+    } // view
+
+}; // PackedIds
+
+
+// === class PackedSequenceSet =========================================
+//
+// Compact set of many sequences, e.g. for the sentences of a language:
+// the ids of the symbols of all sequences are stored one after the other
+// in one buffer of 16 bit words, using two words per id only when there
+// is an id >= 2^16; an open addressing hash table of indices (linear
+// probing, load factor <= 1/2) deduplicates sequences on insertion.
+// Iteration is in order of insertion or, after sort, in lexicographic
+// order as for SequenceSet.
+
+class PackedSequenceSet final // no public base class
+         /*OC+*/ : private ObjectCounter<PackedSequenceSet> /*+OC*/ {
+
+  private:
+
+    mutable SymbolPool sp;
+
+    std::uint32_t              wordsPerId; // 1 while all ids < 2^16, else 2
+    std::vector<std::uint16_t> words;      // ids of all sequences
+    std::vector<std::uint32_t> offsets;    // sequence i has the words in
+                                           //   [offsets[i], offsets[i + 1]),
+                                           //   empty only if moved from
+    std::vector<std::uint32_t> slots;      // 0 for a free slot or 1 + index
+                                           //   of sequence, size is 2^n
+
+    // slot containing ps or the free slot where to insert it
+    std::size_t slotFor(const PackedSequence &ps, std::size_t hash) const;
+
+    void rehash(std::size_t nrOfSlots);
+    void widen(); // re-encodes all ids with two words per id
+
+  public:
+
+    PackedSequenceSet();
+    PackedSequenceSet(const PackedSequenceSet &pss) = default;
+    PackedSequenceSet(PackedSequenceSet &&pss) noexcept; // leaves pss empty
+
+    ~PackedSequenceSet() = default; // not virtual because of final class
+
+    PackedSequenceSet &operator=(const PackedSequenceSet &pss) = default;
+    PackedSequenceSet &operator=(PackedSequenceSet &&pss) noexcept;
+
+    std::size_t size() const  {
+      return offsets.empty() ? 0 : offsets.size() - 1;
+    } // size
+    bool        empty() const { return size() == 0;        }
+
+    PackedSequence operator[](std::size_t idx) const {
+      return PackedSequence(words.data() + offsets[idx],
+                            (offsets[idx + 1] - offsets[idx]) / wordsPerId,
+                            wordsPerId);
+    } // operator[]
+
+    Sequence sequenceAt(std::size_t idx) const; // unpacked copy
+
+    bool insert(const Sequence &seq); // true if inserted, false if duplicate
+    bool contains(const Sequence &seq) const;
+
+    void sort(); // lexicographically as LexLessForSequencePtrs
 
-bool operator==(const SequenceSet &ss1, const SequenceSet &ss2);
+    std::size_t nrOfBytes() const; // memory used, including the hash table
 
-std::ostream &operator<<(std::ostream &os, const SequenceSet &ss);
+}; // PackedSequenceSet
 
 
 #endif
@@ -1,27 +1,51 @@
 // SymbolStuff.cpp:                                       HDO, 2004-2020
 // ---------------
-// Abstract base class Symbol is an interface for T- and NTSymbol only.
+// Base class Symbol is an interface for T- and NTSymbol only.
 // Objects of the derived classes TSymbol and NTSymbol represent terminal
 // and nonterminal symbols for use in (different) grammars respectively.
 // Class SymbolStuff provides a garbage collecting singleton
 // that has factory methods for T- and NTSymbols.
+// SymbolPools may be used concurrently from several threads.
 // =====================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 #include "SymbolStuff.h"
 
 
-static inline void checkForEmptyString(const string &name) {
+static inline void checkForEmptyString(string_view name) {
   if (name.length() == 0)
     throw invalid_argument("invalid empty string for symbol name");
 } // checkForEmptyString
 
 
 // === implementation of "private" class SymbolPoolData ================
+//
+// Symbols are interned in shards selected by the hash of their names.
+// Each shard is an open addressing hash table (linear probing, load
+// factor <= 1/2) with atomic slots: lookups of already interned names
+// never lock, only insertions of new names lock their shard. A grown
+// table replaces the old one atomically, old tables are kept until the
+// pool dies, as concurrent lookups may still probe them.
+// Symbols are found by their ids in chunks of growing size that never
+// move, so lookups by id are lock free, too.
+// Symbols (each followed by its name), entries and the keys of ranks
+// are allocated contiguously in an arena of large blocks.
+// A frozen pool additionally has a minimal perfect hash table over all
+// entries (hash and displace: each bucket of entries gets a seed that
+// maps its entries to distinct slots), so lookups take a single probe.
+// Creating a new entry thaws the pool, i.e. drops the frozen table.
 
 class SymbolPoolData final // no public base class
         /*OC+*/ : private ObjectCounter<SymbolPoolData> /*+OC*/ {
@@ -31,116 +55,544 @@ class SymbolPoolData final // no public base class
 
   private:
 
-    static shared_ptr<SymbolPoolData> instance; // pointer to singleton
-
-    std::unordered_map<std::string,  TSymbol *>  tSyMap;
-    std::unordered_map<std::string, NTSymbol *> ntSyMap;
-
-    SymbolPoolData() = default; // for singleton pattern only
+    struct Entry {              // T- and/or NTSymbol for one name
+      const std::string_view  name; // of first symbol, in arena
+      const size_t            hash;
+      std::atomic< TSymbol *>  tSy;
+      std::atomic<NTSymbol *> ntSy;
+      Entry(std::string_view name, size_t hash)
+      : name(name), hash(hash), tSy(nullptr), ntSy(nullptr) {
+      } // Entry
+    }; // Entry
+
+    struct Table {              // nr. of slots is a power of two
+      const size_t mask;        // nr. of slots - 1
+      std::unique_ptr<std::atomic<Entry *>[]> slots;
+      Table(size_t nrOfSlots)
+      : mask(nrOfSlots - 1), slots(new std::atomic<Entry *>[nrOfSlots]) {
+        for (size_t i = 0; i < nrOfSlots; i++)
+          slots[i].store(nullptr, memory_order_relaxed);
+      } // Table
+    }; // Table
+
+    struct PerfectTable {       // nr. of slots == nr. of entries
+      std::vector<std::uint32_t> seeds; // one per bucket, see slotFor
+      std::vector<Entry *>       slots;
+      PerfectTable(size_t nrOfBuckets, size_t nrOfEntries)
+      : seeds(nrOfBuckets, 0), slots(nrOfEntries, nullptr) {
+      } // PerfectTable
+      static std::uint64_t mix(std::uint64_t x) { // splitmix64 finalizer
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+      } // mix
+      size_t bucketFor(size_t hash) const {
+        return mix(hash) % seeds.size();
+      } // bucketFor
+      size_t slotFor(size_t hash, std::uint32_t seed) const {
+        return mix(hash + seed * 0x9E3779B97F4A7C15ULL) % slots.size();
+      } // slotFor
+      size_t slotFor(size_t hash) const {
+        std::uint32_t seed = seeds[bucketFor(hash)];
+        return (seed & directBit) ? (seed & ~directBit) : slotFor(hash, seed);
+      } // slotFor
+    }; // PerfectTable
+
+    struct Shard {
+      std::mutex                          mtx;     // for insertions only
+      std::atomic<Table *>                table;   // for lookups
+      std::vector<std::unique_ptr<Table>> tables;  // current and old ones
+      std::vector<Entry *>                entries; // in order of insertion
+      Shard() : table(nullptr) {
+      } // Shard
+    }; // Shard
+
+    static const size_t   nrOfShards = 64;
+    static const unsigned chunkBits  = 10; // first chunk has 2^10 symbols
+    static const unsigned nrOfChunks = 22; // for 2^32 - 2^10 symbols
+    static constexpr size_t blockSize = 64 * 1024; // of arena
+    static constexpr std::uint32_t directBit = 0x80000000; // seed is a slot
+    static constexpr std::uint32_t maxSeed   = 1 << 24;    // before giving up
+
+    // singleton pattern with reference counting, guarded by instanceMtx
+    static std::mutex      instanceMtx;
+    static SymbolPoolData *instance;
+    static size_t          nrOfPools;
+
+    Shard shards[nrOfShards];
+
+    std::atomic<Symbol::Id> nextId;  // nr. of symbols created so far
+    std::atomic<Symbol::Id> nrOfTs, nrOfNTs;
+
+    std::mutex chunkMtx;             // for allocation of chunks only
+    std::atomic<std::atomic<Symbol *> *> chunks[nrOfChunks];
+
+    std::mutex rankMtx;              // guards ranks
+    std::map<std::string_view, Symbol::Rank> ranks; // names in lex. order
+
+    std::mutex freezeMtx;            // guards perfectTables
+    std::atomic<PerfectTable *> frozen; // nullptr if pool is not frozen
+    std::vector<std::unique_ptr<PerfectTable>> perfectTables; // all so far
+
+    std::mutex arenaMtx;             // guards blocks and free space
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char  *freeSpace;
+    size_t nrOfFreeBytes;
+
+    SymbolPoolData(); // for singleton pattern only
     SymbolPoolData(const SymbolPool *sp) = delete;
     SymbolPoolData &operator=(const SymbolPool *sp) = delete;
 
+    static size_t hashOf(std::string_view name) {
+      return std::hash<std::string_view>()(name);
+    } // hashOf
+
+    Shard &shardFor(size_t hash) {
+      return shards[hash % nrOfShards];
+    } // shardFor
+
+    const Shard &shardFor(size_t hash) const {
+      return shards[hash % nrOfShards];
+    } // shardFor
+
+    // lookup of entry, lock free
+    Entry *lookup(std::string_view name, size_t hash) const;
+
+    // creation of new entry for (first) symbol sy, shard has to be locked
+    Entry *newEntry(Symbol *sy, size_t hash);
+
+    static void insertInto(Table *t, Entry *e);
+
+    // returns nullptr if there is no perfect hash table, i.e. in case of
+    //   (extremely unlikely) entries with equal hash values
+    static PerfectTable *newPerfectTable(const std::vector<Entry *> &entries);
+
+    // chunk index and index in chunk for id
+    static void locate(Symbol::Id id, unsigned &ci, size_t &i);
+
+    void publish(Symbol *sy);   // makes sy accessible by its id
+    Symbol *symbolWithId(Symbol::Id id) const;
+
+    Symbol::Rank rankFor(std::string_view name);
+
+    void *allocate(size_t size);     // from arena, 8 byte aligned
+
+    template <typename SyT>          // where SyT is TSymbol or NTSymbol
+    SyT *newSymbol(std::string_view name);
+
   public:
 
-    static shared_ptr<SymbolPoolData> getInstance(); // singleton factory
+    static SymbolPoolData *acquire(); // singleton factory
+    static void release();            // deletes singleton with last pool
+
+    void freeze();
+    void thaw() {
+      frozen.store(nullptr, memory_order_release);
+    } // thaw
 
     ~SymbolPoolData(); // not virtual because of final class
 
 }; // SymbolPoolData
 
-shared_ptr<SymbolPoolData> SymbolPoolData::instance;
-
-shared_ptr<SymbolPoolData> SymbolPoolData::getInstance() {
-  if (instance.get() == nullptr)
-    instance.reset(new SymbolPoolData());
+std::mutex      SymbolPoolData::instanceMtx;
+SymbolPoolData *SymbolPoolData::instance  = nullptr;
+size_t          SymbolPoolData::nrOfPools = 0;
+
+SymbolPoolData::SymbolPoolData()
+: nextId(0), nrOfTs(0), nrOfNTs(0),
+  frozen(nullptr), freeSpace(nullptr), nrOfFreeBytes(0) {
+  for (unsigned ci = 0; ci < nrOfChunks; ci++)
+    chunks[ci].store(nullptr, memory_order_relaxed);
+} // SymbolPoolData::SymbolPoolData
+
+SymbolPoolData *SymbolPoolData::acquire() {
+  lock_guard<mutex> lock(instanceMtx);
+  if (instance == nullptr)
+    instance = new SymbolPoolData();
+  nrOfPools++;
   return instance;
-} // SymbolPoolData::getInstance
+} // SymbolPoolData::acquire
+
+void SymbolPoolData::release() {
+  SymbolPoolData *garbage = nullptr;
+  {
+    lock_guard<mutex> lock(instanceMtx);
+    if (--nrOfPools == 0) { // this was the last SymbolPool
+      garbage  = instance;
+      instance = nullptr;
+    } // if
+  }
+  delete garbage;           // outside of lock as it may take a while
+} // SymbolPoolData::release
 
 SymbolPoolData::~SymbolPoolData() {
-  for (auto e: tSyMap) {
-    delete e.second;
-  } // for
-  for (auto e: ntSyMap) {
-    delete e.second;
+  // symbols and entries need no destruction, blocks are freed implicitly
+  for (unsigned ci = 0; ci < nrOfChunks; ci++) {
+    delete[] chunks[ci].load();
   } // for
 } // SymbolPoolData::~SymbolPoolData
 
 
+SymbolPoolData::Entry *SymbolPoolData::lookup(string_view name,
+                                              size_t hash) const {
+  const PerfectTable *pt = frozen.load(memory_order_acquire);
+  if (pt != nullptr) { // single probe, as pt contains all entries
+    Entry *e = pt->slots[pt->slotFor(hash)];
+    return ( (e->hash == hash) && (e->name == name) ) ? e : nullptr;
+  } // if
+  const Table *t = shardFor(hash).table.load(memory_order_acquire);
+  if (t == nullptr)
+    return nullptr;
+  for (size_t i = (hash / nrOfShards) & t->mask; ; i = (i + 1) & t->mask) {
+    Entry *e = t->slots[i].load(memory_order_acquire);
+    if (e == nullptr)
+      return nullptr;
+    if ( (e->hash == hash) && (e->name == name) )
+      return e;
+  } // for
+} // SymbolPoolData::lookup
+
+SymbolPoolData::Entry *SymbolPoolData::newEntry(Symbol *sy, size_t hash) {
+  thaw(); // the frozen table would not contain the new entry
+  Shard &sh = shardFor(hash);
+  Table *t = sh.table.load(memory_order_relaxed);
+  if ( (t == nullptr) || (2 * (sh.entries.size() + 1) > t->mask + 1) ) {
+    t = new Table((t == nullptr) ? 16 : 2 * (t->mask + 1));
+    for (Entry *oldE: sh.entries)
+      insertInto(t, oldE);
+    sh.tables.emplace_back(t);
+    sh.table.store(t, memory_order_release); // lookups switch to t
+  } // if
+  Entry *e = new (allocate(sizeof(Entry))) Entry(sy->name, hash);
+  sh.entries.push_back(e);
+  insertInto(t, e);
+  return e;
+} // SymbolPoolData::newEntry
+
+void SymbolPoolData::insertInto(Table *t, Entry *e) {
+  size_t i = (e->hash / nrOfShards) & t->mask;
+  while (t->slots[i].load(memory_order_relaxed) != nullptr)
+    i = (i + 1) & t->mask;
+  t->slots[i].store(e, memory_order_release);
+} // SymbolPoolData::insertInto
+
+
+void SymbolPoolData::freeze() {
+  lock_guard<mutex> freezeLock(freezeMtx);
+  vector<unique_lock<mutex>> shardLocks; // no new entries meanwhile
+  vector<Entry *> entries;
+  for (Shard &sh: shards) {
+    shardLocks.emplace_back(sh.mtx);
+    entries.insert(entries.end(), sh.entries.begin(), sh.entries.end());
+  } // for
+  if (frozen.load(memory_order_relaxed) != nullptr)
+    return; // still frozen
+  PerfectTable *pt = newPerfectTable(entries);
+  if (pt == nullptr)
+    return; // remain thawed, lookups in shards are correct anyway
+  perfectTables.emplace_back(pt); // kept for concurrent lookups
+  frozen.store(pt, memory_order_release);
+} // SymbolPoolData::freeze
+
+SymbolPoolData::PerfectTable *SymbolPoolData::newPerfectTable(
+                                const vector<Entry *> &entries) {
+  const size_t n = entries.size();
+  if ( (n == 0) || (n >= directBit) )
+    return nullptr;
+  unique_ptr<PerfectTable> pt(new PerfectTable((n + 1) / 2, n));
+  vector<vector<Entry *>> buckets(pt->seeds.size());
+  for (Entry *e: entries)
+    buckets[pt->bucketFor(e->hash)].push_back(e);
+  vector<size_t> order; // of bucket indices, large buckets first
+  for (size_t b = 0; b < buckets.size(); b++) {
+    if (buckets[b].empty())
+      continue;
+    vector<Entry *> &bEs = buckets[b];
+    sort(bEs.begin(), bEs.end(),
+         [](const Entry *e1, const Entry *e2) { return e1->hash < e2->hash; });
+    for (size_t i = 1; i < bEs.size(); i++)
+      if (bEs[i - 1]->hash == bEs[i]->hash)
+        return nullptr; // no seed would separate these entries
+    order.push_back(b);
+  } // for
+  stable_sort(order.begin(), order.end(), [&buckets](size_t b1, size_t b2) {
+    return buckets[b1].size() > buckets[b2].size();
+  });
+  size_t freeSlot = 0;   // all slots before are occupied
+  vector<size_t> slots;  // for entries of current bucket
+  for (size_t b: order) {
+    const vector<Entry *> &bEs = buckets[b];
+    if (bEs.size() == 1) { // single entry: seed is its (free) slot
+      while (pt->slots[freeSlot] != nullptr)
+        freeSlot++;
+      pt->seeds[b] = directBit | static_cast<uint32_t>(freeSlot);
+      pt->slots[freeSlot] = bEs[0];
+      continue;
+    } // if
+    uint32_t seed = 0;
+    do {
+      if (++seed == maxSeed)
+        return nullptr;
+      slots.clear();
+      for (Entry *e: bEs) {
+        size_t s = pt->slotFor(e->hash, seed);
+        if ( (pt->slots[s] != nullptr) ||
+             (find(slots.begin(), slots.end(), s) != slots.end()) )
+          break;
+        slots.push_back(s);
+      } // for
+    } while (slots.size() < bEs.size());
+    pt->seeds[b] = seed;
+    for (size_t i = 0; i < bEs.size(); i++)
+      pt->slots[slots[i]] = bEs[i];
+  } // for
+  return pt.release();
+} // SymbolPoolData::newPerfectTable
+
+
+// chunk ci has 2^(chunkBits + ci) entries for
+//   ids 2^(chunkBits + ci) - 2^chunkBits .. 2^(chunkBits + ci + 1) - 2^chunkBits - 1
+void SymbolPoolData::locate(Symbol::Id id, unsigned &ci, size_t &i) {
+  size_t x = size_t(id) + (size_t(1) << chunkBits);
+  ci = 0;
+  while ((x >> (chunkBits + ci + 1)) != 0)
+    ci++;
+  i = x - (size_t(1) << (chunkBits + ci));
+} // SymbolPoolData::locate
+
+void SymbolPoolData::publish(Symbol *sy) {
+  unsigned ci;
+  size_t   i;
+  locate(sy->id, ci, i);
+  if (ci >= nrOfChunks)
+    throw overflow_error("too many symbols");
+  atomic<Symbol *> *chunk = chunks[ci].load(memory_order_acquire);
+  if (chunk == nullptr) {
+    lock_guard<mutex> lock(chunkMtx);
+    chunk = chunks[ci].load(memory_order_relaxed);
+    if (chunk == nullptr) {
+      size_t size = size_t(1) << (chunkBits + ci);
+      chunk = new atomic<Symbol *>[size];
+      for (size_t j = 0; j < size; j++)
+        chunk[j].store(nullptr, memory_order_relaxed);
+      chunks[ci].store(chunk, memory_order_release);
+    } // if
+  } // if
+  chunk[i].store(sy, memory_order_release);
+} // SymbolPoolData::publish
+
+Symbol *SymbolPoolData::symbolWithId(Symbol::Id id) const {
+  unsigned ci;
+  size_t   i;
+  locate(id, ci, i);
+  const atomic<Symbol *> *chunk = chunks[ci].load(memory_order_acquire);
+  return (chunk == nullptr) ? nullptr : chunk[i].load(memory_order_acquire);
+} // SymbolPoolData::symbolWithId
+
+
+// ranks are labels in a 64 bit space that are never changed once assigned:
+//   new names get the midpoint between the ranks of their neighbours,
+//   names appended at either end keep a fixed distance to save space;
+//   when there is no gap left, the new name shares the rank of its
+//   neighbour and comparisons fall back to names for this pair only
+Symbol::Rank SymbolPoolData::rankFor(string_view name) {
+  lock_guard<mutex> lock(rankMtx);
+  const Symbol::Rank maxRank = numeric_limits<Symbol::Rank>::max();
+  const Symbol::Rank endDist = Symbol::Rank(1) << 32;
+  auto it = ranks.lower_bound(name);
+  if (it != ranks.end() && it->first == name) // aliasing T and NT symbols
+    return it->second;                        //   share their rank
+  Symbol::Rank rank;
+  if (ranks.empty())
+    rank = maxRank / 2;
+  else if (it == ranks.begin()) {             // new first name
+    Symbol::Rank hi = it->second;
+    rank = hi - min(endDist, hi / 2);
+  } else if (it == ranks.end()) {             // new last name
+    Symbol::Rank lo = prev(it)->second;
+    rank = lo + min(endDist, (maxRank - lo) / 2);
+  } else {                                    // between two names
+    Symbol::Rank lo = prev(it)->second;
+    Symbol::Rank hi = it->second;
+    rank = lo + (hi - lo) / 2;
+  } // else
+  ranks.emplace_hint(it, name, rank); // name is a view into arena
+  return rank;
+} // SymbolPoolData::rankFor
+
+
+void *SymbolPoolData::allocate(size_t size) {
+  size = (size + 7) & ~size_t(7);    // keep 8 byte alignment
+  lock_guard<mutex> lock(arenaMtx);
+  if (size > nrOfFreeBytes) {
+    size_t newBlockSize = max(size, blockSize);
+    blocks.emplace_back(new char[newBlockSize]);
+    freeSpace     = blocks.back().get();
+    nrOfFreeBytes = newBlockSize;
+  } // if
+  void *mem = freeSpace;
+  freeSpace     += size;
+  nrOfFreeBytes -= size;
+  return mem;
+} // SymbolPoolData::allocate
+
+template <typename SyT>
+SyT *SymbolPoolData::newSymbol(string_view name) {
+  static_assert(sizeof(SyT) == sizeof(Symbol), "no data in derived classes");
+  if (name.length() > Symbol::maxNameLength)
+    throw length_error("symbol name too long");
+  char *mem   = static_cast<char *>(allocate(sizeof(SyT) + name.length() + 1));
+  char *chars = mem + sizeof(SyT); // name follows record, see Symbol::name
+  memcpy(chars, name.data(), name.length());
+  chars[name.length()] = '\0';
+  SyT *sy = new (mem) SyT(nextId++, rankFor(string_view(chars, name.length())),
+                          name.length());
+  publish(sy);
+  return sy;
+} // SymbolPoolData::newSymbol
+
+
 // === implementation of class "public" SymbolPool =====================
 
 SymbolPool::SymbolPool()
-: spd(SymbolPoolData::getInstance()) {
+: spd(SymbolPoolData::acquire()) {
+  // nothing to do
+} // SymbolPool::SymbolPool
+
+SymbolPool::SymbolPool(const SymbolPool & /*sp*/)
+: /*OC+*/ ObjectCounter<SymbolPool>(), /*+OC*/ spd(SymbolPoolData::acquire()) {
   // nothing to do
 } // SymbolPool::SymbolPool
 
 SymbolPool::~SymbolPool() {
-  if (spd.use_count() > 2) // at least one other SymbolPool alive
-    spd.reset();
-  else { // use_count() == 2, this is the last SymbolPool
-    spd.reset(); // now use_count() == 1, only instance left as owner
-    SymbolPoolData::instance.reset(); // deletes SymbolPoolData
-  } // else
+  SymbolPoolData::release(); // last SymbolPool deletes SymbolPoolData
 } // SymbolPool::~SymbolPool
 
-TSymbol *SymbolPool::tSymbol(const string &name) {
+TSymbol *SymbolPool::tSymbol(string_view name) {
   checkForEmptyString(name);
-  TSymbol *tSy = spd->tSyMap[name];
+  size_t hash = SymbolPoolData::hashOf(name);
+  SymbolPoolData::Entry *e = spd->lookup(name, hash);
+  TSymbol *tSy = (e == nullptr) ? nullptr : e->tSy.load(memory_order_acquire);
+  if (tSy != nullptr) // frequent case: existing symbol found lock free
+    return tSy;
+  lock_guard<mutex> lock(spd->shardFor(hash).mtx);
+  e = spd->lookup(name, hash); // maybe created meanwhile
+  tSy = (e == nullptr) ? nullptr : e->tSy.load(memory_order_relaxed);
   if (tSy == nullptr) {
-    if (spd->ntSyMap.find(name) != spd->ntSyMap.end())
+    if ( (e != nullptr) && (e->ntSy.load(memory_order_relaxed) != nullptr) )
       cout << "WARNING: new terminal " << name <<
               " aliases old nonterminal" << endl;
-    tSy = new TSymbol(name);
-    spd->tSyMap[name] = tSy;
+    tSy = spd->newSymbol<TSymbol>(name);
+    spd->nrOfTs++;
+    if (e == nullptr)
+      e = spd->newEntry(tSy, hash);
+    e->tSy.store(tSy, memory_order_release);
   } // if
   return tSy;
 } // SymbolPool::tSymbol
 
-NTSymbol *SymbolPool::ntSymbol(const string &name) {
+NTSymbol *SymbolPool::ntSymbol(string_view name) {
   checkForEmptyString(name);
-  NTSymbol *ntSy = spd->ntSyMap[name];
+  size_t hash = SymbolPoolData::hashOf(name);
+  SymbolPoolData::Entry *e = spd->lookup(name, hash);
+  NTSymbol *ntSy = (e == nullptr) ? nullptr : e->ntSy.load(memory_order_acquire);
+  if (ntSy != nullptr) // frequent case: existing symbol found lock free
+    return ntSy;
+  lock_guard<mutex> lock(spd->shardFor(hash).mtx);
+  e = spd->lookup(name, hash); // maybe created meanwhile
+  ntSy = (e == nullptr) ? nullptr : e->ntSy.load(memory_order_relaxed);
   if (ntSy == nullptr) {
-    if (spd->tSyMap.find(name) != spd->tSyMap.end())
+    if ( (e != nullptr) && (e->tSy.load(memory_order_relaxed) != nullptr) )
       cout << "WARNING: new nonterminal " << name <<
               " aliases old terminal" << endl;
-    ntSy = new NTSymbol(name);
-    spd->ntSyMap[name] = ntSy;
+    ntSy = spd->newSymbol<NTSymbol>(name);
+    spd->nrOfNTs++;
+    if (e == nullptr)
+      e = spd->newEntry(ntSy, hash);
+    e->ntSy.store(ntSy, memory_order_release);
   } // if
   return ntSy;
 } // SymbolPool::ntSymbol
 
-Symbol *SymbolPool::symbolFor(const std::string &name) const {
+Symbol *SymbolPool::symbolFor(string_view name) const {
   checkForEmptyString(name);
-  auto tSyMapIt = spd->tSyMap.find(name);
-  if (tSyMapIt != spd->tSyMap.end())
-    return tSyMapIt->second;  // tSymbol
-  auto ntSyMapIt = spd->ntSyMap.find(name);
-  if (ntSyMapIt != spd->ntSyMap.end())
-    return ntSyMapIt->second; // ntSymbol
-  return nullptr;
+  SymbolPoolData::Entry *e = spd->lookup(name, SymbolPoolData::hashOf(name));
+  if (e == nullptr)
+    return nullptr;
+  Symbol *sy = e->tSy.load(memory_order_acquire);  // tSymbol
+  if (sy == nullptr)
+    sy = e->ntSy.load(memory_order_acquire);       // ntSymbol
+  return sy;
 } // SymbolPool::symbolFor
 
+TSymbol *SymbolPool::tSymbolFor(string_view name) const {
+  checkForEmptyString(name);
+  SymbolPoolData::Entry *e = spd->lookup(name, SymbolPoolData::hashOf(name));
+  return (e == nullptr) ? nullptr : e->tSy.load(memory_order_acquire);
+} // SymbolPool::tSymbolFor
+
+NTSymbol *SymbolPool::ntSymbolFor(string_view name) const {
+  checkForEmptyString(name);
+  SymbolPoolData::Entry *e = spd->lookup(name, SymbolPoolData::hashOf(name));
+  return (e == nullptr) ? nullptr : e->ntSy.load(memory_order_acquire);
+} // SymbolPool::ntSymbolFor
+
+void SymbolPool::freeze() {
+  spd->freeze();
+} // SymbolPool::freeze
+
+void SymbolPool::thaw() {
+  spd->thaw();
+} // SymbolPool::thaw
+
+bool SymbolPool::isFrozen() const {
+  return spd->frozen.load(memory_order_acquire) != nullptr;
+} // SymbolPool::isFrozen
+
+Symbol *SymbolPool::symbolWithId(Symbol::Id id) const {
+  if (id >= spd->nextId.load())
+    throw out_of_range("invalid symbol id");
+  return spd->symbolWithId(id); // nullptr while id is not published yet
+} // SymbolPool::symbolWithId
+
+Symbol::Id SymbolPool::nrOfSymbols() const {
+  return spd->nextId.load();
+} // SymbolPool::nrOfSymbols
+
 
 std::ostream &operator<<(std::ostream &os, const SymbolPool &sp) {
   os << "symbol pool: " <<
-        sp.spd-> tSyMap.size() << " terminals and " <<
-        sp.spd->ntSyMap.size() << " nonterminals" << endl;
-#if (1) // with contents
+        sp.spd-> nrOfTs.load() << " terminals and " <<
+        sp.spd->nrOfNTs.load() << " nonterminals" << endl;
+#if (1) // with contents, shards are locked, so no entries are added meanwhile
   bool first = true;
   os << "  terminals    = { ";
-  for (auto e: sp.spd->tSyMap) {
-    if (!first)
-      os << ", ";
-    os << *e.second;
-    first = false;
+  for (SymbolPoolData::Shard &s: sp.spd->shards) {
+    lock_guard<mutex> lock(s.mtx);
+    for (SymbolPoolData::Entry *e: s.entries) {
+      const TSymbol *tSy = e->tSy.load(memory_order_acquire);
+      if (tSy == nullptr)
+        continue;
+      if (!first)
+        os << ", ";
+      os << *tSy;
+      first = false;
+    } // for
   } // for
   os << " }" << endl;
   first = true;
   os << "  nonterminals = { ";
-  for (auto e: sp.spd->ntSyMap) {
-    if (!first)
-      os << ", ";
-    os << *e.second;
-    first = false;
+  for (SymbolPoolData::Shard &s: sp.spd->shards) {
+    lock_guard<mutex> lock(s.mtx);
+    for (SymbolPoolData::Entry *e: s.entries) {
+      const NTSymbol *ntSy = e->ntSy.load(memory_order_acquire);
+      if (ntSy == nullptr)
+        continue;
+      if (!first)
+        os << ", ";
+      os << *ntSy;
+      first = false;
+    } // for
   } // for
   os << " }" << endl;
 #endif
@@ -150,64 +602,20 @@ std::ostream &operator<<(std::ostream &os, const SymbolPool &sp) {
 
 // === implementation of class Symbol ==================================
 
-Symbol::Symbol(const string &name)
-: name(name) {
-  // nothing to do
-} // Symbol::Symbol
+static_assert(sizeof(Symbol) <= 16, "compact symbol records expected");
+static_assert(offsetof(Symbol, name) + sizeof(Symbol::Name) == sizeof(Symbol),
+              "characters of name must follow Symbol::name");
 
-Symbol::~Symbol() { // implementation of abstract destructor
+Symbol::Symbol(Kind kind, Id id, Rank rank, size_t len)
+: rank(rank), id(id), kind(kind), name(len) {
   // nothing to do
-} // Symbol::~Symbol
-
-
-bool Symbol::isT() const {
-  return typeid(*this) == typeid( TSymbol);
-} // Symbol::isT
-
-bool Symbol::isNT() const {
-  return typeid(*this) == typeid(NTSymbol);
-} // Symbol::isT
-
-int Symbol::compare(const Symbol &sy) const {
-  return this->name.compare(sy.name);
-} // Symbol::compare
-
-bool isT(const Symbol *sy) {
-   return sy->isT();
-} // isT
-
-bool isNT(const Symbol *sy) {
-   return sy->isNT();
-} // isNT
-
-
-bool operator<(const Symbol &sy1, const Symbol &sy2) {
-  return sy1.name < sy2.name;
-} // operator<
-
-bool operator>(const Symbol &sy1, const Symbol &sy2) {
-  return sy1.name > sy2.name;
-} // operator>
-
-bool operator==(const Symbol &sy1, const Symbol &sy2) {
-  return sy1.name == sy2.name;
-} // operator==
-
-bool operator!=(const Symbol &sy1, const Symbol &sy2) {
-  return sy1.name != sy2.name;
-} // operator!=
-
-
-bool LessForSymbolPtrs::operator()(const Symbol* sy1,
-                                   const Symbol* sy2) const {
-  return sy1->name < sy2->name;
-} // LessForSymbolPtrs::operator()
+} // Symbol::Symbol
 
-bool EqualForSymbolPtrs::operator()(const Symbol* sy1,
-                                    const Symbol* sy2) const {
-  return sy1->name == sy2->name;
-} // EqualForSymbolPtrs::operator()
 
+ostream &operator<<(ostream &os, const Symbol::Name &name) {
+  os << string_view(name);
+  return os;
+} // operator<<
 
 ostream &operator<<(ostream &os, const Symbol &sy) {
   os << sy.name;
@@ -217,16 +625,16 @@ ostream &operator<<(ostream &os, const Symbol &sy) {
 
 // === implementation of class TSymbol =================================
 
-TSymbol::TSymbol(const string &name)
- : Symbol(name) {
+TSymbol::TSymbol(Id id, Rank rank, size_t len)
+ : Symbol(tKind, id, rank, len) {
   // nothing to do
 } // TSymbol::TSymbol
 
 
 // === implementation of class NTSymbol ================================
 
-NTSymbol::NTSymbol(const string &name)
- : Symbol(name) {
+NTSymbol::NTSymbol(Id id, Rank rank, size_t len)
+ : Symbol(ntKind, id, rank, len) {
   // nothing to do
 } // NTSymbol::NTSymbol
 
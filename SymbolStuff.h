@@ -1,20 +1,29 @@
 // SymbolStuff.h:                                         HDO, 2004-2020
 // -------------
-// Abstract base class Symbol is an interface for T- and NTSymbol only.
+// Base class Symbol is an interface for T- and NTSymbol only.
 // Objects of derived classes TSymbol and NTSymbol represent terminal and
 // non-terminal symbols for use in grammars respectively.
 // Class SymbolPool provides a singleton object with factory methods
 // for T- and NTSymbols, it is an implementation of the flyweight pattern.
+// All methods of SymbolPool are thread safe: lookups of existing symbols
+// are lock free, only the creation of new symbols locks (a part of)
+// the pool. The pool owns all symbols and stores them in an arena.
+// Each symbol carries a dense id (0, 1, 2, ...) and a kind tag, so
+// isT/isNT and downcasts need neither RTTI nor virtual calls.
+// Additionally, each symbol carries an immutable rank that is monotone
+// in the lexicographic order of names, so symbols (and sequences of
+// symbols) are compared by integers, names are compared on ties only.
 // =====================================================================
 
 #ifndef SymbolStuff_h
 #define SymbolStuff_h
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
-#include <typeinfo>
-#include <unordered_map>
+#include <string_view>
 
 #include "ObjectCounter.h"
 
@@ -37,21 +46,45 @@ class SymbolPool final // no public base class
 
   private:
 
-    std::shared_ptr<SymbolPoolData> spd; // holds all the symbols
+    SymbolPoolData *spd; // holds all the symbols, shared by all SymbolPools
 
   public:
 
     SymbolPool();
+    SymbolPool(const SymbolPool &sp);
     ~SymbolPool(); // not virtual because of final class
 
     // special kind of factory methods for symbols,
-    //   return pointers to newly constructed or existing symbols
-     TSymbol * tSymbol(const std::string &name);
-    NTSymbol *ntSymbol(const std::string &name);
+    //   return pointers to newly constructed or existing symbols,
+    //   names are std::string_views, so looking up existing symbols
+    //   for std::strings, C strings or tokens does not allocate
+     TSymbol * tSymbol(std::string_view name);
+    NTSymbol *ntSymbol(std::string_view name);
 
     // lookup method to retrieve existing symbol,
-    //   returns nullptr for unknown name
-    Symbol *symbolFor(const std::string &name) const;
+    //   returns nullptr for unknown name, the TSymbol for an alias
+    Symbol *symbolFor(std::string_view name) const;
+
+    // lookup methods to retrieve existing symbols of one kind,
+    //   return nullptr if there is no such symbol for name
+     TSymbol * tSymbolFor(std::string_view name) const;
+    NTSymbol *ntSymbolFor(std::string_view name) const;
+
+    // after all symbols have been interned (e.g. after loading grammars)
+    //   freeze builds a minimal perfect hash table over all names, so
+    //   lookups of names take a single probe; interning a new name thaws
+    //   the pool implicitly, thaw does so explicitly; both apply to the
+    //   shared symbols, i.e. to all SymbolPools
+    void freeze();
+    void thaw();
+    bool isFrozen() const;
+
+    // lookup method for dense ids, valid ids are 0 .. nrOfSymbols() - 1,
+    //   throws out_of_range for others; returns nullptr for an id whose
+    //   symbol is still being created by another thread, ids of symbols
+    //   returned by this pool are always published
+    Symbol *symbolWithId(std::uint32_t id) const;
+    std::uint32_t nrOfSymbols() const;
 
 }; // SymbolPool
 
@@ -59,90 +92,186 @@ std::ostream &operator<<(std::ostream &os, const SymbolPool &sp);
 
 
 // === class Symbol ====================================================
+//
+// Symbols are compact records of 16 bytes in an arena of SymbolPoolData,
+// each record is immediately followed by the (0-terminated) characters
+// of its name, so the name stores its length only. Symbols have no
+// virtual methods and are neither copied nor destroyed individually:
+// the arena is freed with SymbolPoolData.
 
-class Symbol { // abstract base class, so no object counting necessary
+class Symbol { // base class, so no object counting necessary
 
-private:
+  public:
+
+    typedef std::uint32_t Id;  // dense index of symbol in SymbolPool
+    typedef std::uint64_t Rank;// rank1 < rank2 ==> name1 < name2
+
+    enum Kind: unsigned char { tKind, ntKind };
+
+    static const std::size_t maxNameLength = 0xFFFF;
+
+    // name of a symbol: last member of the record, so its characters
+    //   follow it immediately; it is used like a std::string_view but
+    //   cannot be copied, as copies would not be followed by the name
+    class Name {
+      private:
+        const std::uint16_t len;
+      public:
+        explicit Name(std::size_t len) : len(static_cast<std::uint16_t>(len)) {
+        } // Name
+        Name(const Name &n) = delete;
+        Name &operator=(const Name &n) = delete;
+        operator std::string_view() const {
+          return std::string_view(reinterpret_cast<const char *>(this + 1), len);
+        } // operator std::string_view
+        std::size_t length() const {
+          return len;
+        } // length
+        int compare(std::string_view s) const {
+          return std::string_view(*this).compare(s);
+        } // compare
+        friend bool operator==(const Name &n, std::string_view s) {
+          return std::string_view(n) == s;
+        } // operator==
+        friend bool operator!=(const Name &n, std::string_view s) {
+          return std::string_view(n) != s;
+        } // operator!=
+        friend bool operator< (const Name &n, std::string_view s) {
+          return std::string_view(n) <  s;
+        } // operator<
+        friend bool operator< (std::string_view s, const Name &n) {
+          return s <  std::string_view(n);
+        } // operator<
+    }; // Name
+
+  private:
+
+    Symbol(const Symbol &sy) = delete;
+    Symbol &operator=(const Symbol &sy) = delete;
 
-    Symbol(const Symbol *sy) = delete;
-    Symbol &operator=(const Symbol *sy) = delete;
+  public:
+
+    const Rank rank; // assigned by SymbolPool, never changes
+    const Id   id;   // unique for all symbols in SymbolPool
+    const Kind kind; // tag for T or NT, replaces typeid
+    const Name name; // const as symbols may be elements of sets,
+                     //   characters follow this record
 
   protected:
 
-    Symbol(const std::string &name);
-    virtual ~Symbol() = 0;     // abstract to gain an abstract class
-                               //   but implementation is necessary (!)
+    Symbol(Kind kind, Id id, Rank rank, std::size_t len);
+    ~Symbol() = default;       // records are freed with their arena
 
   public:
 
-    const std::string name;    // const as symbols may be elements of sets
+    bool isT () const {        // is symbol a T  in a grammar
+      return kind ==  tKind;
+    } // isT
 
-    virtual bool isT () const; // is symbol a T  in a grammar
-    virtual bool isNT() const; // is symbol a NT in a grammar
+    bool isNT() const {        // is symbol a NT in a grammar
+      return kind == ntKind;
+    } // isNT
 
-    int compare(const Symbol &sy) const;
+    int compare(const Symbol &sy) const { // lexicographically by name
+      if (this == &sy)
+        return 0;
+      if (rank != sy.rank)
+        return (rank < sy.rank) ? -1 : +1;
+      return name.compare(sy.name); // rare: equal ranks or aliases
+    } // compare
 
 }; // Symbol
 
-bool isT (const Symbol *sy);   // sy->isT () <==> isT (sy)
-bool isNT(const Symbol *sy);   // sy->isNT() <==> isNT(sy)
+inline bool isT (const Symbol *sy) {  // sy->isT () <==> isT (sy)
+  return sy->isT();
+} // isT
+
+inline bool isNT(const Symbol *sy) {  // sy->isNT() <==> isNT(sy)
+  return sy->isNT();
+} // isNT
+
+inline bool operator< (const Symbol &sy1, const Symbol &sy2) {
+  return sy1.compare(sy2) <  0;
+} // operator<
+
+inline bool operator> (const Symbol &sy1, const Symbol &sy2) {
+  return sy1.compare(sy2) >  0;
+} // operator>
 
-bool operator< (const Symbol &sy1, const Symbol &sy2);
-bool operator> (const Symbol &sy1, const Symbol &sy2);
-bool operator==(const Symbol &sy1, const Symbol &sy2);
-bool operator!=(const Symbol &sy1, const Symbol &sy2);
+inline bool operator==(const Symbol &sy1, const Symbol &sy2) {
+  return sy1.compare(sy2) == 0;
+} // operator==
+
+inline bool operator!=(const Symbol &sy1, const Symbol &sy2) {
+  return sy1.compare(sy2) != 0;
+} // operator!=
 
 struct LessForSymbolPtrs {
-  bool operator()(const Symbol *sy1, const Symbol *sy2) const;
+  typedef void is_transparent; // allows lookups by name in sets and maps
+  bool operator()(const Symbol *sy1, const Symbol *sy2) const {
+    return sy1->compare(*sy2) < 0;
+  } // operator()
+  bool operator()(const Symbol *sy, std::string_view name) const {
+    return sy->name < name;
+  } // operator()
+  bool operator()(std::string_view name, const Symbol *sy) const {
+    return name < sy->name;
+  } // operator()
 }; // LessForSymbolPtrs
 
 struct EqualForSymbolPtrs {
-  bool operator()(const Symbol *sy1, const Symbol *sy2) const;
+  bool operator()(const Symbol *sy1, const Symbol *sy2) const {
+    return sy1->compare(*sy2) == 0;
+  } // operator()
 }; // EqualForSymbolPtrs
 
+std::ostream &operator<<(std::ostream &os, const Symbol::Name &name);
 std::ostream &operator<<(std::ostream &os, const Symbol &sy);
 
 
 // === class TSymbol ===================================================
 
-class TSymbol: public Symbol
-  /*OC+*/ , private ObjectCounter<TSymbol> /*+OC*/ {
+class TSymbol: public Symbol { // no object counting, see SymbolPool
 
   friend class SymbolPoolData;
-  friend class SymbolPool;
 
   private:
 
-    TSymbol(const TSymbol *tSy) = delete;
-    TSymbol &operator=(const TSymbol *tSy) = delete;
-
-  protected:
-
-    TSymbol(const std::string &name);
-    virtual ~TSymbol() = default;
+    TSymbol(Id id, Rank rank, std::size_t len);
 
 }; // TSymbol
 
 
 // === class NTSymbol ==================================================
 
-class NTSymbol: public Symbol
-  /*OC+*/ , private ObjectCounter<NTSymbol> /*+OC*/ {
+class NTSymbol: public Symbol { // no object counting, see SymbolPool
 
   friend class SymbolPoolData;
-  friend class SymbolPool;
 
   private:
 
-    NTSymbol(const NTSymbol *tSy) = delete;
-    NTSymbol &operator=(const NTSymbol *tSy) = delete;
+    NTSymbol(Id id, Rank rank, std::size_t len);
 
-  protected:
+}; // NTSymbol
 
-    NTSymbol(const std::string &name);
-    virtual ~NTSymbol() = default;
 
-}; // NTSymbol
+// tag based downcasts replacing dynamic_cast,
+//   sy must be of the corresponding kind, so check isT/isNT before
+inline TSymbol *asT(Symbol *sy) {
+  return static_cast<TSymbol *>(sy);
+} // asT
+
+inline const TSymbol *asT(const Symbol *sy) {
+  return static_cast<const TSymbol *>(sy);
+} // asT
+
+inline NTSymbol *asNT(Symbol *sy) {
+  return static_cast<NTSymbol *>(sy);
+} // asNT
+
+inline const NTSymbol *asNT(const Symbol *sy) {
+  return static_cast<const NTSymbol *>(sy);
+} // asNT
 
 
 #endif
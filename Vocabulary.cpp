@@ -3,6 +3,7 @@
 // Generic class Vocabulary shall be instantiated with [T|NT]Symbol only.
 // An object of an instance of the generic class Vocabulary is a set of
 // pointers to (possibly different types of) symbols: V = VT + VNT:
+// Membership is a bitset over the dense symbol ids.
 // Vocabulary.cpp would not be necessary, but this one provides
 // a simple test program.
 // =====================================================================
@@ -84,6 +85,12 @@ try {
     v.insert(sy);
   cout << "v: " << v << endl;
 
+  vT2.insert(sp->tSymbol("u"));
+  vT3.insert(sp->tSymbol("s"));
+  cout << "vT2 + vT3: " << (vT2 + vT3) << endl;
+  cout << "vT2 * vT3: " << (vT2 * vT3) << endl;
+  cout << "vT2 - vT3: " << (vT2 - vT3) << endl;
+
   delete sp;
 
 } catch(const exception &e) {
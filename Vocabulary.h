@@ -3,6 +3,14 @@
 // Generic class Vocabulary shall be instantiated with [T|NT]Symbol only.
 // An object of an instance of the generic class Vocabulary is a set of
 // pointers to (possibly different types of) symbols: V = VT + VNT:
+// Membership is a bitset over the dense symbol ids, so contains and
+// insert are O(1) and +, * and - work on whole words, size is a
+// popcount; additionally, the elements are kept in a vector for
+// iteration and for lookups by name, which is sorted lazily: insert
+// appends and only the first iteration or lookup by name after
+// insertions out of lexicographic order sorts these elements into the
+// others. So a vocabulary shared by several threads has to be sorted
+// before, see sort.
 // Vocabulary.cpp would not be necessary, but the existing one
 // contains a simple test program.
 // =====================================================================
@@ -10,64 +18,240 @@
 #ifndef Vocabulary_h
 #define Vocabulary_h
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <set>
+#include <iterator>
 #include <stdexcept>
 #include <string>
-#include <typeinfo>
+#include <string_view>
+#include <vector>
 
 #include "ObjectCounter.h"
 #include "SymbolStuff.h"
 
 
 template <typename SyT> // where SyT is either TSymbol or NTSymbol
-class Vocabulary: public std::set<SyT *, LessForSymbolPtrs>
-        /*OC+*/ , private ObjectCounter<Vocabulary<SyT>> /*+OC*/ {
+class Vocabulary // no public base class
+        /*OC+*/ : private ObjectCounter<Vocabulary<SyT>> /*+OC*/ {
 
   private:
 
-    typedef std::set<SyT *, LessForSymbolPtrs> Base;
+    typedef std::uint64_t Word;
+    static const unsigned wordBits = 64;
 
-    // helper class to support binary search for T- and NTSymbols
-    class XSymbol final: public SyT
-               /*OC+*/ , private ObjectCounter<XSymbol> /*+OC*/ {
+    std::vector<Word>          bits;  // bit sy->id is set <==> sy is an element
+    mutable std::vector<SyT *> elems; // all elements, the first nrOfSorted
+    mutable std::size_t nrOfSorted = 0; //   in lexicographic order, the
+                                        //   rest in order of insertion
 
-      public:
+    static std::size_t wordIdx(Symbol::Id id) {
+      return id / wordBits;
+    } // wordIdx
 
-        XSymbol(const std::string &name)
-        : SyT(name) {
-          // nothing left to do
-        } // XSymbol
+    static Word bitMask(Symbol::Id id) {
+      return Word(1) << (id % wordBits);
+    } // bitMask
 
-    }; // XSymbol
+    static std::size_t popcount(Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<std::size_t>(__builtin_popcountll(w));
+#else
+      std::size_t n = 0;
+      for (; w != 0; w &= w - 1)
+        n++;
+      return n;
+#endif
+    } // popcount
+
+    typename std::vector<SyT *>::const_iterator
+    lowerBound(std::string_view name) const {
+      sort();
+      return std::lower_bound(elems.begin(), elems.end(), name,
+                              LessForSymbolPtrs());
+    } // lowerBound
+
+    template <typename Pred>
+    void removeElemsIf(Pred pred) { // stable, so sorted elems stay sorted
+      sort();
+      elems.erase(std::remove_if(elems.begin(), elems.end(), pred),
+                  elems.end());
+      nrOfSorted = elems.size();
+    } // removeElemsIf
 
   public:
 
+    typedef typename std::vector<SyT *>::const_iterator const_iterator;
+    typedef const_iterator iterator; // elements must not be changed
+
     Vocabulary() = default;
     Vocabulary(const Vocabulary &v) = default;
+    Vocabulary(Vocabulary &&v) noexcept
+    : /*OC+*/ ObjectCounter<Vocabulary<SyT>>(), /*+OC*/
+      bits(std::move(v.bits)), elems(std::move(v.elems)),
+      nrOfSorted(v.nrOfSorted) {
+      v.nrOfSorted = 0; // moved vectors of v are empty
+    } // Vocabulary
 
     Vocabulary &operator=(const Vocabulary &v) = default;
+    Vocabulary &operator=(Vocabulary &&v) noexcept {
+      if (this != &v) {
+        bits       = std::move(v.bits);
+        elems      = std::move(v.elems);
+        nrOfSorted = v.nrOfSorted;
+        v.bits.clear();
+        v.elems.clear();
+        v.nrOfSorted = 0;
+      } // if
+      return *this;
+    } // operator=
+
+    // sorts the elements inserted out of order into the others: in
+    //   O(k log k + n) for k such elements, O(1) if there are none
+    void sort() const {
+      if (nrOfSorted == elems.size())
+        return;
+      auto mid = elems.begin() + nrOfSorted;
+      std::sort(mid, elems.end(), LessForSymbolPtrs());
+      std::inplace_merge(elems.begin(), mid, elems.end(), LessForSymbolPtrs());
+      nrOfSorted = elems.size();
+    } // sort
+
+    const_iterator begin() const { // in lexicographic order
+      sort();
+      return elems.begin();
+    } // begin
 
-    bool contains(SyT *sy) const {
-      return Base::find(sy) != Base::end();
+    const_iterator end() const {
+      sort();
+      return elems.end();
+    } // end
+
+    std::size_t size() const {
+      std::size_t n = 0;
+      for (Word w: bits)
+        n += popcount(w);
+      return n;
+    } // size
+
+    bool empty() const {
+      return elems.empty();
+    } // empty
+
+    void clear() {
+      bits.clear();
+      elems.clear();
+      nrOfSorted = 0;
+    } // clear
+
+    bool contains(const SyT *sy) const {
+      std::size_t wi = wordIdx(sy->id);
+      return (wi < bits.size()) && ((bits[wi] & bitMask(sy->id)) != 0);
     } // contains
 
-    SyT *symbolFor(const std::string &name) const {
-      XSymbol xSy(name); // temporary for search only
-      auto it =  Base::find(&xSy);
-      if ( it != Base::end() )
+    bool insert(SyT *sy) { // returns false if sy already is an element
+      if (sy == nullptr)
+        throw std::invalid_argument("invalid nullptr for symbol");
+      if (contains(sy))
+        return false;
+      std::size_t wi = wordIdx(sy->id);
+      if (wi >= bits.size())
+        bits.resize(wi + 1, 0);
+      bits[wi] |= bitMask(sy->id);
+      if ( (nrOfSorted == elems.size()) && // frequent case: in order
+           (elems.empty() || LessForSymbolPtrs()(elems.back(), sy)) )
+        nrOfSorted++;
+      elems.push_back(sy); // else sorted on demand, see sort
+      return true;
+    } // insert
+
+    bool erase(const SyT *sy) { // returns false if sy is not an element
+      if (!contains(sy))
+        return false;
+      bits[wordIdx(sy->id)] &= ~bitMask(sy->id);
+      removeElemsIf([sy](const SyT *e) { return e == sy; });
+      return true;
+    } // erase
+
+    SyT *symbolFor(std::string_view name) const {
+      auto it = lowerBound(name);
+      if ( (it != elems.end()) && ((*it)->name == name) )
         return *it;
       else
         return nullptr;
     } // symbolFor
 
-    bool hasSymbolWith(const std::string &name) const {
-      XSymbol xSy(name); // temporary for search only
-      return Base::find(&xSy) != Base::end();
+    bool hasSymbolWith(std::string_view name) const {
+      return symbolFor(name) != nullptr;
     } // hasSymbolWith
 
+    // set operations: union (+), intersection (*) and difference (-)
+
+    Vocabulary &operator+=(const Vocabulary &v) {
+      sort();
+      std::vector<SyT *> newElems;
+      for (SyT *sy: v) // sorted
+        if (!contains(sy))
+          newElems.push_back(sy);
+      if (newElems.empty())
+        return *this;
+      if (bits.size() < v.bits.size())
+        bits.resize(v.bits.size(), 0);
+      for (std::size_t i = 0; i < v.bits.size(); i++)
+        bits[i] |= v.bits[i];
+      std::vector<SyT *> merged;
+      merged.reserve(elems.size() + newElems.size());
+      std::merge(elems.begin(), elems.end(),
+                 newElems.begin(), newElems.end(),
+                 std::back_inserter(merged), LessForSymbolPtrs());
+      elems.swap(merged);
+      nrOfSorted = elems.size();
+      return *this;
+    } // operator+=
+
+    Vocabulary &operator*=(const Vocabulary &v) {
+      if (bits.size() > v.bits.size())
+        bits.resize(v.bits.size());
+      for (std::size_t i = 0; i < bits.size(); i++)
+        bits[i] &= v.bits[i];
+      removeElemsIf([&v](const SyT *e) { return !v.contains(e); });
+      return *this;
+    } // operator*=
+
+    Vocabulary &operator-=(const Vocabulary &v) {
+      std::size_t n = std::min(bits.size(), v.bits.size());
+      for (std::size_t i = 0; i < n; i++)
+        bits[i] &= ~v.bits[i];
+      removeElemsIf([&v](const SyT *e) { return v.contains(e); });
+      return *this;
+    } // operator-=
+
 }; // Vocabulary<SyT>
 
+template <typename SyT>
+Vocabulary<SyT> operator+(Vocabulary<SyT> v1, const Vocabulary<SyT> &v2) {
+  v1 += v2;
+  return v1;
+} // operator+
+
+template <typename SyT>
+Vocabulary<SyT> operator*(Vocabulary<SyT> v1, const Vocabulary<SyT> &v2) {
+  v1 *= v2;
+  return v1;
+} // operator*
+
+template <typename SyT>
+Vocabulary<SyT> operator-(Vocabulary<SyT> v1, const Vocabulary<SyT> &v2) {
+  v1 -= v2;
+  return v1;
+} // operator-
+
+template <typename SyT>
+bool operator==(const Vocabulary<SyT> &v1, const Vocabulary<SyT> &v2) {
+  return (v1.size() == v2.size()) &&
+         std::equal(v1.begin(), v1.end(), v2.begin());
+} // operator==
+
 template <typename SyT>
 static std::ostream &operator<<(std::ostream &os,
                                 const Vocabulary<SyT> &v) {